@@ -0,0 +1,361 @@
+/*
+  Wio_Terminal_E5_LoRa_Tx. A demonstration of two-way LoRa communication
+  between two (or more) Wio Terminal devices equipped with Wio-E5.
+  Copyright (C) 2023 by Kongduino
+  kongduino@protonmail.com https://github.com/Kongduino
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  For commercial and/or closed-source usage and licensing, please contact the author.
+*/
+
+// Non-blocking AT engine for the Wio-E5 on Serial1. Commands wait in a
+// queue and go out one at a time; atPoll(), called from loop(), sends
+// them, assembles reply lines and matches them to the command in flight.
+// The E5 answers "AT+NAME=..." with "+NAME: ...", or "+NAME: ERROR(n)";
+// plain OK / ERROR lines are accepted too. Anything else, like received
+// packets, goes to atUrcHandler.
+
+#define AT_QUEUE_LEN 8
+#define AT_CMD_LEN 48
+#define AT_EXPECT_LEN 16
+#define AT_LINE_LEN 544 // +TEST: RX "..." with a 255-byte payload in hex
+#define AT_TIMEOUT_MS 1000
+
+#define AT_OK 0
+#define AT_ERROR 1
+#define AT_TIMEOUT 2
+
+// Called once per command: result, and the line that answered it (empty
+// on timeout).
+typedef void (*atCallback)(uint8_t result, const char *line, void *ctx);
+// Called for every line that isn't an answer.
+typedef void (*atUrcCallback)(const char *line);
+
+struct atCommand {
+  char text[AT_CMD_LEN];
+  char prefix[AT_EXPECT_LEN]; // "+NAME:", from the command
+  char expect[AT_EXPECT_LEN]; // narrower match, if any
+  uint16_t timeout;
+  atCallback done;
+  void *ctx;
+  // Sent after text as "HEX", for commands too long for text. Must stay
+  // valid until done is called.
+  const uint8_t *data;
+  uint8_t dataLen;
+};
+
+// Received packets come as two URCs:
+//   +TEST: LEN:5, RSSI:-30, SNR:10
+//   +TEST: RX "48656C6C6F"
+// e5RxFeed() takes them a byte at a time and decodes the hex straight
+// into the caller's buffer, so the payload is never held as text and
+// may contain any byte. The packet is ready at the closing quote.
+#define E5RX_HEAD 0
+#define E5RX_INFO 1
+#define E5RX_HEX 2
+#define E5RX_SKIP 3
+// e5RxFeed() results
+#define E5RX_NONE 0
+#define E5RX_PAYLOAD 1 // the byte was part of the hex payload
+#define E5RX_PACKET 2 // closing quote: packet is ready
+#define E5RX_HEAD_LEN 11 // both heads below are 11 characters
+
+struct e5Packet {
+  uint16_t len; // bytes in bytes[]
+  int16_t rssi, snr;
+  uint8_t *bytes;
+  bool truncated; // longer than the buffer
+};
+
+struct e5RxParser {
+  uint8_t *buf;
+  uint16_t cap;
+  uint8_t state;
+  char head[E5RX_HEAD_LEN];
+  uint8_t headLen;
+  // LEN, RSSI, SNR from the info line
+  int16_t values[3];
+  uint8_t field;
+  bool negative;
+  bool haveInfo;
+  uint16_t count;
+  uint8_t hi;
+  bool odd;
+  e5Packet packet;
+  uint32_t packets, errors;
+};
+
+void e5RxBegin(e5RxParser &p, uint8_t *buf, uint16_t cap) {
+  memset(&p, 0, sizeof(p));
+  p.buf = buf;
+  p.cap = cap;
+}
+
+void e5RxEndField(e5RxParser &p) {
+  if (p.field < 3 && p.negative) p.values[p.field] = -p.values[p.field];
+  p.negative = false;
+}
+
+uint8_t e5RxFeed(e5RxParser &p, char c) {
+  if (c == 10) {
+    if (p.state == E5RX_INFO) {
+      e5RxEndField(p);
+      p.haveInfo = p.field == 2;
+    }
+    p.state = E5RX_HEAD;
+    p.headLen = 0;
+    return E5RX_NONE;
+  }
+  if (c == 13) return E5RX_NONE;
+  switch (p.state) {
+    case E5RX_HEAD: {
+      p.head[p.headLen++] = c;
+      bool info = strncmp(p.head, "+TEST: LEN:", p.headLen) == 0;
+      bool rx = strncmp(p.head, "+TEST: RX \"", p.headLen) == 0;
+      if (!info && !rx) p.state = E5RX_SKIP;
+      else if (p.headLen == E5RX_HEAD_LEN) {
+        if (info) {
+          p.state = E5RX_INFO;
+          memset(p.values, 0, sizeof(p.values));
+          p.field = 0;
+          p.negative = false;
+          p.haveInfo = false;
+        } else {
+          p.state = E5RX_HEX;
+          p.count = 0;
+          p.odd = false;
+        }
+      }
+      return E5RX_NONE;
+    }
+    case E5RX_INFO:
+      if (c == ':') {
+        e5RxEndField(p);
+        p.field++;
+      } else if (c == '-') p.negative = true;
+      else if (c >= '0' && c <= '9' && p.field < 3) p.values[p.field] = p.values[p.field] * 10 + c - '0';
+      return E5RX_NONE;
+    case E5RX_HEX: {
+      if (c == '"') {
+        p.state = E5RX_SKIP;
+        // Length-aware: the hex must match the LEN just announced.
+        if (p.odd || !p.haveInfo || p.values[0] != p.count) {
+          p.errors++;
+          p.haveInfo = false;
+          return E5RX_NONE;
+        }
+        p.packet.len = p.count < p.cap ? p.count : p.cap;
+        p.packet.truncated = p.count > p.cap;
+        p.packet.rssi = p.values[1];
+        p.packet.snr = p.values[2];
+        p.packet.bytes = p.buf;
+        p.haveInfo = false;
+        p.packets++;
+        return E5RX_PACKET;
+      }
+      uint8_t v = hexValue(c);
+      if (v == HEX_INVALID) {
+        p.errors++;
+        p.haveInfo = false;
+        p.state = E5RX_SKIP;
+        return E5RX_NONE;
+      }
+      if (!p.odd) p.hi = v;
+      else {
+        if (p.count < p.cap) p.buf[p.count] = (p.hi << 4) | v;
+        p.count++;
+      }
+      p.odd = !p.odd;
+      return E5RX_PAYLOAD;
+    }
+  }
+  return E5RX_NONE;
+}
+
+// Called with each received packet, from atPoll().
+typedef void (*atPacketCallback)(const e5Packet &pkt);
+
+struct atEngine {
+  atCommand queue[AT_QUEUE_LEN];
+  uint8_t head, count;
+  bool inFlight;
+  uint32_t sentAt;
+  char line[AT_LINE_LEN + 1];
+  uint16_t len;
+  bool overlong;
+  uint32_t timeouts;
+};
+atEngine at;
+atUrcCallback atUrcHandler = NULL;
+atPacketCallback atPacketHandler = NULL;
+e5RxParser atRx;
+
+// Decodes received packets into buf and hands them to cb; their hex
+// then never goes through the line buffer. cb NULL stops that.
+void atListen(uint8_t *buf, uint16_t cap, atPacketCallback cb) {
+  e5RxBegin(atRx, buf, cap);
+  atPacketHandler = cb;
+}
+
+bool startsWith(const char *s, const char *prefix) {
+  return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+// Queues cmd, without "\r\n". expect narrows what counts as the answer,
+// e.g. "+TEST: RXLRPKT", so a packet arriving meanwhile isn't taken for
+// it. False if the queue is full.
+bool atSend(const char *cmd, atCallback done = NULL, void *ctx = NULL, uint16_t timeout = AT_TIMEOUT_MS, const char *expect = NULL) {
+  if (at.count == AT_QUEUE_LEN || strlen(cmd) >= AT_CMD_LEN) return false;
+  atCommand &c = at.queue[(at.head + at.count) % AT_QUEUE_LEN];
+  strcpy(c.text, cmd);
+  // "AT+NAME=..." or "AT+NAME?" -> "+NAME:", "AT" -> "+AT:"
+  uint8_t n = 0;
+  const char *p = cmd[2] ? cmd + 2 : "+AT";
+  while (*p && *p != '=' && *p != '?' && n < AT_EXPECT_LEN - 2) c.prefix[n++] = *p++;
+  c.prefix[n++] = ':';
+  c.prefix[n] = 0;
+  c.expect[0] = 0;
+  if (expect) strncat(c.expect, expect, AT_EXPECT_LEN - 1);
+  c.timeout = timeout;
+  c.done = done;
+  c.ctx = ctx;
+  c.data = NULL;
+  c.dataLen = 0;
+  at.count++;
+  return true;
+}
+
+// Same, with data sent after cmd in quoted hex, as in
+// AT+TEST=TXLRPKT,"48656C6C6F". data isn't copied.
+bool atSendHex(const char *cmd, const uint8_t *data, uint8_t len, atCallback done = NULL, void *ctx = NULL, uint16_t timeout = AT_TIMEOUT_MS, const char *expect = NULL) {
+  if (!atSend(cmd, done, ctx, timeout, expect)) return false;
+  atCommand &c = at.queue[(at.head + at.count - 1) % AT_QUEUE_LEN];
+  c.data = data;
+  c.dataLen = len;
+  return true;
+}
+
+void atWriteHex(const uint8_t *data, uint8_t len) {
+  char hex[65];
+  Serial1.print('"');
+  for (uint8_t i = 0; i < len; i += 32) {
+    uint8_t n = len - i < 32 ? len - i : 32;
+    Serial1.write(hex, hexEncode(data + i, n, hex) - hex);
+  }
+  Serial1.print('"');
+}
+
+bool atBusy() {
+  return at.count > 0;
+}
+
+void atComplete(uint8_t result, const char *line) {
+  atCommand &c = at.queue[at.head];
+  at.head = (at.head + 1) % AT_QUEUE_LEN;
+  at.count--;
+  at.inFlight = false;
+  // The callback may queue more: the slot is free by now.
+  if (c.done) c.done(result, line, c.ctx);
+}
+
+void atDispatch(const char *line) {
+  if (at.inFlight) {
+    const atCommand &c = at.queue[at.head];
+    if (strcmp(line, "OK") == 0) {
+      atComplete(AT_OK, line);
+      return;
+    }
+    if (startsWith(line, "ERROR")) {
+      atComplete(AT_ERROR, line);
+      return;
+    }
+    if (startsWith(line, c.prefix)) {
+      if (strstr(line, "ERROR")) {
+        atComplete(AT_ERROR, line);
+        return;
+      }
+      if (c.expect[0] == 0 || startsWith(line, c.expect)) {
+        atComplete(AT_OK, line);
+        return;
+      }
+    }
+  }
+  if (atUrcHandler) atUrcHandler(line);
+}
+
+void atPoll() {
+  while (Serial1.available()) {
+    char c = Serial1.read();
+    if (atPacketHandler) {
+      uint8_t r = e5RxFeed(atRx, c);
+      if (r == E5RX_PAYLOAD) continue;
+      if (r == E5RX_PACKET) {
+        atPacketHandler(atRx.packet);
+        continue;
+      }
+    }
+    if (c == 13) continue;
+    if (c != 10) {
+      if (at.len < AT_LINE_LEN) at.line[at.len++] = c;
+      else at.overlong = true;
+      continue;
+    }
+    at.line[at.len] = 0;
+    if (at.overlong) SerialUSB.printf("AT: line over %d bytes, truncated\n", AT_LINE_LEN);
+    if (at.len > 0) atDispatch(at.line);
+    at.len = 0;
+    at.overlong = false;
+  }
+  if (at.inFlight && millis() - at.sentAt > at.queue[at.head].timeout) {
+    at.timeouts++;
+    SerialUSB.printf("AT: %s timed out\n", at.queue[at.head].text);
+    atComplete(AT_TIMEOUT, "");
+  }
+  if (!at.inFlight && at.count > 0) {
+    const atCommand &c = at.queue[at.head];
+    Serial1.print(c.text);
+    if (c.data) atWriteHex(c.data, c.dataLen);
+    Serial1.print("\r\n");
+    at.inFlight = true;
+    at.sentAt = millis();
+  }
+}
+
+struct atResult {
+  bool done;
+  uint8_t result;
+  char *reply;
+  size_t n;
+};
+
+void atStore(uint8_t result, const char *line, void *ctx) {
+  atResult *r = (atResult*)ctx;
+  if (r->reply && r->n > 0) {
+    strncpy(r->reply, line, r->n - 1);
+    r->reply[r->n - 1] = 0;
+  }
+  r->result = result;
+  r->done = true;
+}
+
+// Runs cmd after whatever is queued and waits for its answer, polling
+// rather than sleeping. Not for use from a callback.
+uint8_t atCommandSync(const char *cmd, char *reply = NULL, size_t n = 0, uint16_t timeout = AT_TIMEOUT_MS) {
+  atResult r = {false, AT_ERROR, reply, n};
+  while (!atSend(cmd, atStore, &r, timeout)) atPoll();
+  while (!r.done) atPoll();
+  return r.result;
+}
@@ -21,177 +21,956 @@
   For commercial and/or closed-source usage and licensing, please contact the author.
 */
 
-#undef max
-#undef min
-#include <string>
-#include <vector>
-
-using namespace std;
 #include "SoftwareSerial1.h"
 
-SoftwareSerial gps(3, 2);
-float latitude, longitude;
-char buffer[256];
-char gpsBuff[128];
-char timeBuff[128];
-uint8_t ix = 0;
-vector<string> userStrings;
-char UTC[7] = {0};
-uint8_t SIV = 0;
-double lastRefresh = 0;
-bool waitForDollar = true, hasFix = false;
-
-#define GPS_DELAY 5000
-#define GPS_DURATION 800
-uint32_t lastGPS;
-
-float parseDegrees(const char *term) {
-  float value = (float)(atof(term) / 100.0);
-  uint16_t left = (uint16_t)value;
-  value = (value - left) * 1.66666666666666;
-  value += left;
-  return value;
-}
-
-vector<string> parseNMEA(string nmea) {
-  vector<string>result;
-  if (nmea.at(0) != '$') {
+// RMC + GGA at 1 Hz, plus GSV every few fixes, is ~200 bytes/s at most:
+// 256 bytes covers a loop() stalled for over a second. 128 bytes of
+// TX hold the longest configuration sentence, so sending one doesn't wait.
+SoftwareSerialT<256, 128> gps(3, 2);
+// Degrees x 1e7 in an int32: ~1 cm resolution everywhere on the globe.
+struct gpsPosition {
+  int32_t latitude;
+  int32_t longitude;
+};
+
+// Everything we know about the receiver's solution, as integers. The
+// parsers only store numbers; consumers format what they need, when they
+// need it. Each group remembers the gpsFixSeq it was last updated at, so
+// a consumer can tell what changed since it last looked.
+struct GpsFix {
+  gpsPosition position;
+  int32_t altitude; // cm above MSL
+  uint8_t hour, minute, second;
+  uint8_t day, month, year; // year - 2000
+  bool valid; // RMC status A
+  uint8_t quality; // GGA: 0 none, 1 GPS, 2 DGPS...
+  uint32_t fixAt; // millis() at the last RMC or GGA, which set the two above
+  uint8_t mode; // GSA: 1 none, 2 2D, 3 3D. GSA is off, see gpsFixMode()
+  uint8_t satsUsed;
+  uint8_t satsInView;
+  uint16_t pdop, hdop, vdop; // x 100
+  int32_t speed; // km/h x 100
+  int32_t track; // degrees x 100, true north
+  uint32_t positionSeq, timeSeq, dateSeq, dopSeq, velocitySeq, satSeq;
+};
+GpsFix gpsFix;
+// Bumped once per sentence that updates gpsFix.
+uint32_t gpsFixSeq = 0;
+// Odd while a sentence is being applied, see getGpsFix().
+volatile uint32_t gpsFixLock = 0;
+
+// NMEA 0183 caps a sentence at 82 characters, including the $ and CR/LF.
+#define NMEA_MAX_LEN 82
+
+// Resumable line assembler: fed one byte at a time, keeps its state
+// between calls, so it never has to wait for the rest of a sentence.
+// The XOR checksum is accumulated as the bytes go by, so a corrupt
+// sentence is rejected before anyone tokenizes it.
+enum nmeaState {
+  NMEA_IDLE, NMEA_BODY, NMEA_CK1, NMEA_CK2, NMEA_EOL
+};
+
+enum nmeaResult {
+  NMEA_PENDING, NMEA_VALID, NMEA_INVALID
+};
+
+struct nmeaFramer {
+  char line[NMEA_MAX_LEN + 1];
+  uint8_t len;
+  uint8_t state;
+  uint8_t checksum;
+  uint8_t expected;
+};
+nmeaFramer gpsFramer = {{0}, 0, NMEA_IDLE, 0, 0};
+
+// Satellites in view, assembled from all the GSV messages of a cycle.
+// Readers get the front table, which only ever holds complete cycles;
+// the next cycle is built in gsvCycle and published by a buffer swap.
+#define GSV_MAX_SATS 32
+
+struct gpsSatellite {
+  char talker; // 'P' GPS, 'L' GLONASS, 'A' Galileo, 'B' BeiDou
+  uint8_t prn;
+  int8_t elevation; // degrees
+  uint16_t azimuth; // degrees
+  uint8_t snr; // dB-Hz, 0 when not tracked
+};
+
+struct gpsSkyView {
+  gpsSatellite sats[GSV_MAX_SATS];
+  uint8_t count;
+  uint32_t seq; // gpsFixSeq at publication
+};
+gpsSkyView skyViews[2];
+uint8_t skyFront = 0;
+gpsSatellite gsvCycle[GSV_MAX_SATS];
+uint8_t gsvCycleCount = 0, gsvNextMessage = 0;
+char gsvTalker = 0;
+
+const gpsSkyView &getSkyView() {
+  return skyViews[skyFront];
+}
+
+// Checked sentences waiting for dispatch. Fixed size, so memory stays
+// flat however long we run: when full, the oldest line is dropped and
+// counted. A new RMC or GGA overwrites one still pending, since only
+// the latest position matters.
+#define NMEA_QUEUE_LEN 8 // power of 2
+
+struct nmeaLine {
+  char text[NMEA_MAX_LEN + 1];
+  uint8_t len;
+};
+
+struct nmeaQueue {
+  nmeaLine lines[NMEA_QUEUE_LEN];
+  uint8_t head;
+  uint8_t count;
+  uint32_t overflows;
+  uint32_t coalesced;
+};
+nmeaQueue gpsQueue;
+
+// Accepted/rejected counts per talker+type, eg "GPRMC". Sentences with
+// an unreadable header all land in the "?????" slot.
+#define NMEA_STATS_MAX 16
+
+struct nmeaStat {
+  char id[6];
+  uint32_t accepted;
+  uint32_t rejected;
+};
+nmeaStat nmeaStats[NMEA_STATS_MAX];
+uint8_t nmeaStatCount = 0;
+
+
+// A field is a view into the sentence buffer: no copy, no heap.
+// NMEA sentences are at most 82 characters, so a field length fits in a byte.
+#define NMEA_MAX_FIELDS 24
+
+struct nmeaField {
+  const char *ptr;
+  uint8_t len;
+};
+
+struct nmeaFields {
+  nmeaField fields[NMEA_MAX_FIELDS];
+  uint8_t count;
+};
+
+// Out-of-range fields come back empty, so parsers don't need to check count.
+nmeaField nmeaGet(const nmeaFields &result, uint8_t n) {
+  if (n >= result.count) return {"", 0};
+  return result.fields[n];
+}
+
+bool nmeaEmpty(const nmeaFields &result, uint8_t n) {
+  return nmeaGet(result, n).len == 0;
+}
+
+bool nmeaIs(const nmeaFields &result, uint8_t n, const char *value) {
+  nmeaField f = nmeaGet(result, n);
+  return f.len == strlen(value) && memcmp(f.ptr, value, f.len) == 0;
+}
+
+char nmeaChar(const nmeaFields &result, uint8_t n) {
+  nmeaField f = nmeaGet(result, n);
+  return f.len > 0 ? f.ptr[0] : 0;
+}
+
+// Turns "ddmm.mmmmm" (or "dddmm.mmmmm") into degrees x 1e7, integers only.
+// Minutes are kept to 10 decimals, so the division by 60 is the only
+// rounding step: 1e-10 minute is far below half a unit of the result,
+// and digits past the 10th can't move it across a rounding boundary.
+// Rejects more than 5 digits before the dot, over 180 degrees and
+// minutes of 60 or more.
+bool parseDegrees(nmeaField term, int32_t &value) {
+  uint32_t whole = 0;
+  uint64_t fraction = 0;
+  uint8_t i = 0, digits = 0;
+  if (term.len == 0) return false;
+  for (; i < term.len && term.ptr[i] != '.'; i++) {
+    if (i == 5 || term.ptr[i] < '0' || term.ptr[i] > '9') return false;
+    whole = whole * 10 + (term.ptr[i] - '0');
+  }
+  if (whole > 18000 || whole % 100 >= 60) return false;
+  for (i++; i < term.len; i++) {
+    if (term.ptr[i] < '0' || term.ptr[i] > '9') return false;
+    if (digits == 10) continue;
+    fraction = fraction * 10 + (term.ptr[i] - '0');
+    digits++;
+  }
+  for (; digits < 10; digits++) fraction *= 10;
+  uint64_t minutes = (whole % 100) * 10000000000ULL + fraction; // minutes x 1e10
+  value = (int32_t)((whole / 100) * 10000000UL + (minutes + 30000) / 60000);
+  return true;
+}
+
+// Reads lat, N/S, lon, E/W starting at field n.
+bool parsePosition(const nmeaFields &result, uint8_t n, gpsPosition &pos) {
+  if (!parseDegrees(nmeaGet(result, n), pos.latitude)) return false;
+  if (!parseDegrees(nmeaGet(result, n + 2), pos.longitude)) return false;
+  if (nmeaChar(result, n + 1) == 'S') pos.latitude = -pos.latitude;
+  if (nmeaChar(result, n + 3) == 'W') pos.longitude = -pos.longitude;
+  return true;
+}
+
+// Writes a value scaled by 10^decimals as a signed decimal, eg "-48.1173000".
+char *formatFixed(char *dst, int32_t value, uint8_t decimals) {
+  uint32_t magnitude = value < 0 ? -(int64_t)value : value, scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+  sprintf(dst, "%s%lu.%0*lu", value < 0 ? "-" : "", (unsigned long)(magnitude / scale), decimals, (unsigned long)(magnitude % scale));
+  return dst;
+}
+
+char *formatDegrees(char *dst, int32_t value) {
+  return formatFixed(dst, value, 7);
+}
+
+uint8_t parseNMEA(const char *nmea, size_t len, nmeaFields &result) {
+  result.count = 0;
+  if (len == 0 || nmea[0] != '$') {
     Serial.println("Not an NMEA sentence!");
-    return result;
+    return 0;
   }
   size_t lastFound = 0;
-  size_t found = nmea.find(",", lastFound);
-  while (found < nmea.size() && found != string::npos) {
-    string token = nmea.substr(lastFound, found - lastFound);
-    result.push_back(token);
-    lastFound = found + 1;
-    found = nmea.find(",", lastFound);
-  }
-  string token = nmea.substr(lastFound, found - lastFound);
-  result.push_back(token);
-  lastFound = found + 1;
-  found = nmea.find(",", lastFound);
-  return result;
-}
-
-void parseGPRMC(vector<string>result) {
-  if (result.at(1) != "") {
-    sprintf(timeBuff, "%s:%s:%s UTC", result.at(1).substr(0, 2).c_str(), result.at(1).substr(2, 2).c_str(), result.at(1).substr(4, 2).c_str());
-    Serial.println(timeBuff);
-  }
-  if (result.at(2) == "V") {
-    Serial.printf("Invalid fix! [%c]", result.at(2));
-    hasFix = false;
-  } else {
-    Serial.printf("Valid fix! [%c]", result.at(2));
-    hasFix = true;
-  }
-  if (result.at(3) != "") {
-    float newLatitude, newLongitude;
-    int8_t signLat = 1, signLong = 1;
-    if (result.at(4).c_str()[0] == 'W') signLat = -1;
-    if (result.at(6).c_str()[0] == 'S') signLong = -1;
-    newLatitude = signLat * parseDegrees(result.at(3).c_str());
-    newLongitude = signLong * parseDegrees(result.at(5).c_str());
-    if (newLatitude != latitude || newLongitude != longitude) {
-      latitude = newLatitude;
-      longitude = newLongitude;
-      sprintf(gpsBuff, "Coordinates:\n%3.8f, %3.8f\n", latitude, longitude);
-      Serial.print(gpsBuff);
-      // refreshDisplay();
+  for (size_t i = 0; i <= len && result.count < NMEA_MAX_FIELDS; i++) {
+    if (i == len || nmea[i] == ',') {
+      result.fields[result.count].ptr = nmea + lastFound;
+      result.fields[result.count].len = i - lastFound;
+      result.count++;
+      lastFound = i + 1;
     }
   }
+  return result.count;
 }
 
-void parseGPGGA(vector<string>result) {
-  if (result.at(1) != "") {
-    sprintf(timeBuff, "UTC Time: %s:%s:%s\n", result.at(1).substr(0, 2).c_str(), result.at(1).substr(2, 2).c_str(), result.at(1).substr(4, 2).c_str());
-    Serial.print(timeBuff);
+// Reads a decimal like "-12.5" into an integer scaled by 10^decimals.
+bool parseFixed(nmeaField term, uint8_t decimals, int32_t &value) {
+  int32_t v = 0;
+  bool negative = false, dot = false;
+  uint8_t i = 0;
+  if (term.len == 0) return false;
+  if (term.ptr[0] == '-') {
+    negative = true;
+    i++;
   }
-  //  if (result.at(6) == "0") Serial.println("Invalid fix!");
-  //  else Serial.println("Valid fix!");
-  if (result.at(2) != "") {
-    latitude = parseDegrees(result.at(2).c_str());
-    longitude = parseDegrees(result.at(4).c_str());
-    sprintf(timeBuff, "Coordinates: %3.8f %c, %3.8f %c\n", latitude, result.at(3).c_str()[0], longitude, result.at(5).c_str()[0]);
-    Serial.print(timeBuff);
+  for (; i < term.len; i++) {
+    char c = term.ptr[i];
+    if (c == '.' && !dot) {
+      dot = true;
+      continue;
+    }
+    if (c < '0' || c > '9') return false;
+    if (dot) {
+      if (decimals == 0) continue; // truncate extra decimals
+      decimals--;
+    }
+    v = v * 10 + (c - '0');
   }
+  for (; decimals > 0; decimals--) v *= 10;
+  value = negative ? -v : v;
+  return true;
+}
+
+void parseFixPosition(const nmeaFields &result, uint8_t n) {
+  gpsPosition pos;
+  if (!parsePosition(result, n, pos)) return;
+  gpsFix.position = pos;
+  gpsFix.positionSeq = gpsFixSeq;
+}
+
+bool parseTime(const nmeaFields &result, uint8_t n) {
+  nmeaField t = nmeaGet(result, n);
+  if (t.len < 6) return false;
+  gpsFix.hour = (t.ptr[0] - '0') * 10 + (t.ptr[1] - '0');
+  gpsFix.minute = (t.ptr[2] - '0') * 10 + (t.ptr[3] - '0');
+  gpsFix.second = (t.ptr[4] - '0') * 10 + (t.ptr[5] - '0');
+  gpsFix.timeSeq = gpsFixSeq;
+  return true;
 }
 
-void parseGPGLL(vector<string>result) {
-  if (result.at(1) != "") {
-    latitude = parseDegrees(result.at(1).c_str());
-    longitude = parseDegrees(result.at(3).c_str());
-    sprintf(gpsBuff, "Coordinates:\n%3.8f %c, %3.8f %c\n", latitude, result.at(2).c_str()[0], longitude, result.at(4).c_str()[0]);
-    Serial.print(gpsBuff);
+void parseGPRMC(const nmeaFields &result) {
+  parseTime(result, 1);
+  gpsFix.valid = nmeaIs(result, 2, "A");
+  gpsFix.fixAt = millis();
+  parseFixPosition(result, 3);
+  int32_t knots, track;
+  if (parseFixed(nmeaGet(result, 7), 2, knots) && parseFixed(nmeaGet(result, 8), 2, track)) {
+    gpsFix.speed = knots * 1852 / 1000;
+    gpsFix.track = track;
+    gpsFix.velocitySeq = gpsFixSeq;
+  }
+  nmeaField d = nmeaGet(result, 9);
+  if (d.len == 6) {
+    gpsFix.day = (d.ptr[0] - '0') * 10 + (d.ptr[1] - '0');
+    gpsFix.month = (d.ptr[2] - '0') * 10 + (d.ptr[3] - '0');
+    gpsFix.year = (d.ptr[4] - '0') * 10 + (d.ptr[5] - '0');
+    gpsFix.dateSeq = gpsFixSeq;
   }
 }
 
-void parseGPGSV(vector<string>result) {
-  if (result.at(1) != "") {
-    uint8_t newSIV = atoi(result.at(3).c_str());
-    if (SIV != newSIV) {
-      sprintf(buffer, "Message %s / %s. SIV: %s\n", result.at(2).c_str(), result.at(1).c_str(), result.at(3).c_str());
-      Serial.print(buffer);
-      SIV = newSIV;
-    }
+void parseGPGGA(const nmeaFields &result) {
+  parseTime(result, 1);
+  parseFixPosition(result, 2);
+  int32_t v;
+  if (parseFixed(nmeaGet(result, 6), 0, v)) gpsFix.quality = v;
+  gpsFix.fixAt = millis();
+  if (parseFixed(nmeaGet(result, 7), 0, v)) {
+    gpsFix.satsUsed = v;
+    gpsFix.satSeq = gpsFixSeq;
+  }
+  if (parseFixed(nmeaGet(result, 8), 2, v)) {
+    gpsFix.hdop = v;
+    gpsFix.dopSeq = gpsFixSeq;
+  }
+  if (parseFixed(nmeaGet(result, 9), 2, v)) gpsFix.altitude = v;
+}
+
+void parseGPGLL(const nmeaFields &result) {
+  parseFixPosition(result, 1);
+  parseTime(result, 5);
+}
+
+// Swaps the finished cycle in. Other constellations' satellites are
+// carried over from the current table, since each talker has its own
+// GSV cycle.
+void publishSkyView(char talker) {
+  const gpsSkyView &front = skyViews[skyFront];
+  gpsSkyView &back = skyViews[skyFront ^ 1];
+  back.count = 0;
+  for (uint8_t i = 0; i < front.count; i++)
+    if (front.sats[i].talker != talker) back.sats[back.count++] = front.sats[i];
+  for (uint8_t i = 0; i < gsvCycleCount && back.count < GSV_MAX_SATS; i++)
+    back.sats[back.count++] = gsvCycle[i];
+  back.seq = gpsFixSeq;
+  skyFront ^= 1;
+}
+
+void parseGPGSV(const nmeaFields &result) {
+  // $GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45
+  int32_t total, number, v;
+  if (parseFixed(nmeaGet(result, 3), 0, v)) {
+    gpsFix.satsInView = v;
+    gpsFix.satSeq = gpsFixSeq;
+  }
+  if (!parseFixed(nmeaGet(result, 1), 0, total) || !parseFixed(nmeaGet(result, 2), 0, number)) return;
+  char talker = result.fields[0].ptr[2];
+  if (number == 1) {
+    gsvCycleCount = 0;
+    gsvTalker = talker;
+  } else if (number != gsvNextMessage || talker != gsvTalker) {
+    // Missed a message: wait for the start of the next cycle.
+    gsvNextMessage = 0;
+    return;
+  }
+  gsvNextMessage = number + 1;
+  // Blocks of 4 fields from field 4; NMEA 4.1 appends a signal ID.
+  for (uint8_t n = 4; n + 3 < result.count && gsvCycleCount < GSV_MAX_SATS; n += 4) {
+    gpsSatellite &sat = gsvCycle[gsvCycleCount];
+    if (!parseFixed(nmeaGet(result, n), 0, v)) continue;
+    sat.talker = talker;
+    sat.prn = v;
+    sat.elevation = parseFixed(nmeaGet(result, n + 1), 0, v) ? v : 0;
+    sat.azimuth = parseFixed(nmeaGet(result, n + 2), 0, v) ? v : 0;
+    sat.snr = parseFixed(nmeaGet(result, n + 3), 0, v) ? v : 0;
+    gsvCycleCount++;
+  }
+  if (number == total) {
+    publishSkyView(talker);
+    gsvNextMessage = 0;
   }
 }
 
-void parseGPTXT(vector<string>result) {
+void parseGPTXT(const nmeaFields &result) {
   //$GPTXT, 01, 01, 02, ANTSTATUS = INIT
-  if (result.at(1) != "") {
-    sprintf(buffer, " . Message %s / %s. Severity: %s\n . Message text: %s\n",
-            result.at(2).c_str(), result.at(1).c_str(), result.at(3).c_str(), result.at(4).c_str(), result.at(5).c_str());
-    Serial.print(buffer);
+  // Rare, and meant for humans: worth printing as it comes.
+  if (!nmeaEmpty(result, 1)) {
+    nmeaField severity = nmeaGet(result, 3), text = nmeaGet(result, 4);
+    Serial.printf(" . GPS message [%.*s]: %.*s\n", severity.len, severity.ptr, text.len, text.ptr);
   }
 }
 
-void parseGPVTG(vector<string>result) {
-  Serial.println("Track Made Good and Ground Speed.");
-  if (result.at(1) != "") {
-    sprintf(buffer, " . True track made good %s [%s].\n", result.at(1).c_str(), result.at(2).c_str());
-    Serial.print(buffer);
+void parseGPVTG(const nmeaFields &result) {
+  // $GPVTG,054.7,T,034.4,M,005.5,N,010.2,K
+  int32_t track, speed;
+  if (parseFixed(nmeaGet(result, 1), 2, track) && parseFixed(nmeaGet(result, 7), 2, speed)) {
+    gpsFix.track = track;
+    gpsFix.speed = speed;
+    gpsFix.velocitySeq = gpsFixSeq;
   }
-  if (result.at(3) != "") {
-    sprintf(buffer, " . Magnetic track made good %s [%s].\n", result.at(3).c_str(), result.at(4).c_str());
-    Serial.print(buffer);
+}
+
+void parseGPGSA(const nmeaFields &result) {
+  // $GPGSA,A,3,15,29,23,,,,,,,,,,12.56,11.96,3.81
+  int32_t v;
+  if (parseFixed(nmeaGet(result, 2), 0, v)) gpsFix.mode = v;
+  int32_t pdop, hdop, vdop;
+  if (parseFixed(nmeaGet(result, 15), 2, pdop) && parseFixed(nmeaGet(result, 16), 2, hdop) && parseFixed(nmeaGet(result, 17), 2, vdop)) {
+    gpsFix.pdop = pdop;
+    gpsFix.hdop = hdop;
+    gpsFix.vdop = vdop;
+    gpsFix.dopSeq = gpsFixSeq;
   }
-  if (result.at(5) != "") {
-    sprintf(buffer, " . Speed: %s %s.\n", result.at(5).c_str(), result.at(6).c_str());
-    Serial.print(buffer);
+}
+
+// Copies gpsFix without ever catching it half-updated, even from a
+// callback running outside loop().
+void getGpsFix(GpsFix &fix) {
+  uint32_t before;
+  do {
+    before = gpsFixLock;
+    __sync_synchronize();
+    fix = gpsFix;
+    __sync_synchronize();
+  } while ((before & 1) || before != gpsFixLock);
+}
+
+// 1 no fix, 2 2D, 3 3D. The receiver isn't asked for GSA, where this
+// would come from (see configureGPS()), so it is worked out from RMC and
+// GGA: a position takes 3 satellites, an altitude 4. Once neither has
+// come for GPS_FIX_STALE_MS, the receiver has gone quiet: no fix, so its
+// last position isn't passed off as a live one.
+#define GPS_FIX_STALE_MS 3000
+uint8_t gpsFixMode(const GpsFix &fix) {
+  if (millis() - fix.fixAt > GPS_FIX_STALE_MS) return 1;
+  if (!fix.valid && fix.quality == 0) return 1;
+  return fix.quality > 0 && fix.satsUsed >= 4 ? 3 : 2;
+}
+
+// Human-readable summary, only built when someone asks for it.
+char *formatGpsFix(const GpsFix &fix, char *dst) {
+  char lat[16], lon[16], alt[16], hdop[8], speed[16];
+  const char *modes[] = {"no fix", "no fix", "2D", "3D"};
+  sprintf(dst, "%02d:%02d:%02d UTC %s %s, %s alt %sm sats %d/%d HDOP %s %skm/h",
+          fix.hour, fix.minute, fix.second, modes[gpsFixMode(fix)],
+          formatDegrees(lat, fix.position.latitude), formatDegrees(lon, fix.position.longitude),
+          formatFixed(alt, fix.altitude, 2), fix.satsUsed, fix.satsInView,
+          formatFixed(hdop, fix.hdop, 2), formatFixed(speed, fix.speed, 2));
+  return dst;
+}
+
+// Returns NMEA_VALID when fr.line holds a complete sentence whose checksum
+// matched (stored without CR/LF or *hh), NMEA_INVALID when a sentence was
+// complete but corrupt, NMEA_PENDING otherwise.
+uint8_t nmeaFeed(nmeaFramer &fr, char c) {
+  if (c == '$') {
+    // A $ always starts over: a truncated sentence is simply dropped.
+    fr.line[0] = '$';
+    fr.len = 1;
+    fr.checksum = 0;
+    fr.state = NMEA_BODY;
+    return NMEA_PENDING;
   }
-  if (result.at(7) != "") {
-    sprintf(buffer, " . Speed: %s %s.\n", result.at(7).c_str(), result.at(8).c_str());
-    Serial.print(buffer);
+  uint8_t n;
+  switch (fr.state) {
+    case NMEA_BODY:
+      if (c == '*') {
+        fr.line[fr.len] = 0;
+        fr.state = NMEA_CK1;
+        return NMEA_PENDING;
+      }
+      if (c == 13 || c == 10 || fr.len == NMEA_MAX_LEN) {
+        // No checksum, or too long to be NMEA: line noise.
+        fr.line[fr.len] = 0;
+        fr.state = NMEA_IDLE;
+        return NMEA_INVALID;
+      }
+      fr.checksum ^= c;
+      fr.line[fr.len++] = c;
+      return NMEA_PENDING;
+    case NMEA_CK1:
+      n = hexValue(c);
+      if (n == HEX_INVALID) break;
+      fr.expected = n << 4;
+      fr.state = NMEA_CK2;
+      return NMEA_PENDING;
+    case NMEA_CK2:
+      n = hexValue(c);
+      if (n == HEX_INVALID) break;
+      fr.expected |= n;
+      fr.state = NMEA_EOL;
+      return NMEA_PENDING;
+    case NMEA_EOL:
+      if (c != 13 && c != 10) break;
+      fr.state = NMEA_IDLE;
+      return fr.expected == fr.checksum ? NMEA_VALID : NMEA_INVALID;
+    default:
+      return NMEA_PENDING;
   }
+  fr.state = NMEA_IDLE;
+  return NMEA_INVALID;
 }
 
-void parseGPGSA(vector<string>result) {
-  // $GPGSA,A,3,15,29,23,,,,,,,,,,12.56,11.96,3.81
-  Serial.println("GPS DOP and active satellites");
-  if (result.at(1) == "A") Serial.println(" . Mode: Automatic");
-  else if (result.at(1) == "M") Serial.println(" . Mode: Manual");
-  else Serial.println(" . Mode: ???");
-  if (result.at(2) == "1") {
-    Serial.println(" . Fix not available.");
+void countNMEA(const char *line, uint8_t len, bool valid) {
+  char id[6] = "?????";
+  if (len >= 6) {
+    bool readable = true;
+    for (uint8_t i = 0; i < 5; i++) {
+      if ((line[i + 1] < 'A' || line[i + 1] > 'Z') && (line[i + 1] < '0' || line[i + 1] > '9')) readable = false;
+    }
+    if (readable) memcpy(id, line + 1, 5);
+  }
+  uint8_t i;
+  for (i = 0; i < nmeaStatCount; i++)
+    if (memcmp(nmeaStats[i].id, id, 5) == 0) break;
+  if (i == nmeaStatCount) {
+    // Table full: fold anything new into the last slot.
+    if (nmeaStatCount == NMEA_STATS_MAX) i = NMEA_STATS_MAX - 1;
+    else {
+      memcpy(nmeaStats[i].id, id, 6);
+      nmeaStats[i].accepted = nmeaStats[i].rejected = 0;
+      nmeaStatCount++;
+    }
+  }
+  if (valid) nmeaStats[i].accepted++;
+  else nmeaStats[i].rejected++;
+}
+
+bool nmeaCoalesces(const char *line, uint8_t len) {
+  return len >= 6 && (memcmp(line + 3, "RMC", 3) == 0 || memcmp(line + 3, "GGA", 3) == 0);
+}
+
+void nmeaPush(nmeaQueue &q, const char *line, uint8_t len) {
+  nmeaLine *slot = NULL;
+  if (nmeaCoalesces(line, len)) {
+    for (uint8_t i = 0; i < q.count; i++) {
+      nmeaLine &pending = q.lines[(q.head + i) & (NMEA_QUEUE_LEN - 1)];
+      if (pending.len >= 6 && memcmp(pending.text + 3, line + 3, 3) == 0) {
+        slot = &pending;
+        q.coalesced++;
+        break;
+      }
+    }
+  }
+  if (slot == NULL) {
+    if (q.count == NMEA_QUEUE_LEN) {
+      q.head = (q.head + 1) & (NMEA_QUEUE_LEN - 1);
+      q.count--;
+      q.overflows++;
+    }
+    slot = &q.lines[(q.head + q.count) & (NMEA_QUEUE_LEN - 1)];
+    q.count++;
+  }
+  memcpy(slot->text, line, len);
+  slot->text[len] = 0;
+  slot->len = len;
+}
+
+// Oldest pending line, or NULL. Valid until the next nmeaPush().
+const nmeaLine *nmeaPop(nmeaQueue &q) {
+  if (q.count == 0) return NULL;
+  const nmeaLine *line = &q.lines[q.head];
+  q.head = (q.head + 1) & (NMEA_QUEUE_LEN - 1);
+  q.count--;
+  return line;
+}
+
+void printNMEAStats() {
+  SerialUSB.println("NMEA sentences: accepted / rejected");
+  for (uint8_t i = 0; i < nmeaStatCount; i++)
+    SerialUSB.printf(" . %s: %lu / %lu\n", nmeaStats[i].id, nmeaStats[i].accepted, nmeaStats[i].rejected);
+  SerialUSB.printf(" . Queue: %lu coalesced, %lu dropped\n", gpsQueue.coalesced, gpsQueue.overflows);
+}
+
+void printRxStats() {
+  SoftwareSerialStats st;
+  gps.rxStats(st);
+  SerialUSB.printf("GPS serial: %lu received, %lu dropped, %lu framing errors\n", st.received, st.dropped, st.framingErrors);
+  SerialUSB.printf(" . Buffer: max %u, mean %lu bytes\n", st.maxOccupancy, st.received ? (uint32_t)(st.occupancySum / st.received) : 0);
+  SerialUSB.printf(" . Entry jitter (cycles): max %lu\n", st.maxJitter);
+  for (uint8_t i = 0; i < SS_JITTER_BINS; i++) {
+    if (i < SS_JITTER_BINS - 1) SerialUSB.printf("   < %5lu: %lu\n", (uint32_t)SS_JITTER_BIN0 << i, st.jitter[i]);
+    else SerialUSB.printf("   >=%5lu: %lu\n", (uint32_t)SS_JITTER_BIN0 << (i - 1), st.jitter[i]);
+  }
+}
+
+// Sentence types and talkers packed into integers, so dispatch is a
+// switch on a constant instead of a string compare per candidate.
+constexpr uint32_t nmeaType(const char *t) {
+  return ((uint32_t)t[0] << 16) | ((uint32_t)t[1] << 8) | (uint32_t)t[2];
+}
+
+constexpr uint16_t nmeaTalker(const char *t) {
+  return ((uint16_t)t[0] << 8) | (uint16_t)t[1];
+}
+
+typedef void (*nmeaHandler)(const nmeaFields &);
+
+// GPS, multi-constellation, GLONASS, Galileo and BeiDou sentences carry
+// the same payloads, so they share the parsers.
+nmeaHandler nmeaLookup(const char *verb) {
+  switch (nmeaTalker(verb)) {
+    case nmeaTalker("GP"):
+    case nmeaTalker("GN"):
+    case nmeaTalker("GL"):
+    case nmeaTalker("GA"):
+    case nmeaTalker("GB"):
+    case nmeaTalker("BD"):
+      break;
+    default:
+      return NULL;
+  }
+  switch (nmeaType(verb + 2)) {
+    case nmeaType("RMC"): return parseGPRMC;
+    case nmeaType("GSV"): return parseGPGSV;
+    case nmeaType("GGA"): return parseGPGGA;
+    case nmeaType("GLL"): return parseGPGLL;
+    case nmeaType("GSA"): return parseGPGSA;
+    case nmeaType("VTG"): return parseGPVTG;
+    case nmeaType("TXT"): return parseGPTXT;
+    default: return NULL;
+  }
+}
+
+void dispatchNMEA(const char *line, size_t len) {
+  if (len < 6) return;
+  nmeaHandler handler = nmeaLookup(line + 1);
+  if (handler == NULL) {
+    Serial.println(line);
     return;
-  } else if (result.at(2) == "2") Serial.println(" . Fix: 2D");
-  else if (result.at(2) == "3") Serial.println(" . Fix: 3D");
-  else {
-    Serial.println(" . Fix: ???");
+  }
+  nmeaFields result;
+  if (parseNMEA(line, len, result) == 0) return;
+  gpsFixLock++;
+  __sync_synchronize();
+  gpsFixSeq++;
+  handler(result);
+  __sync_synchronize();
+  gpsFixLock++;
+}
+
+// Record/replay over the USB console (see README). Recording echoes the
+// raw GPS bytes to SerialUSB. Replaying takes bytes from SerialUSB instead
+// of the GPS port, until a Ctrl-D, and runs them through the same framer
+// and parsers. Replay skips the coalescing queue, so the decoded stream
+// doesn't depend on how the host's writes were chunked.
+bool gpsRecording = false, gpsReplaying = false, gpsReplayQuiet = false;
+uint32_t replayBytes, replaySentences;
+// CPU cycles and heap allocations spent framing and parsing, not waiting
+// on USB or printing.
+uint32_t replayAllocs;
+uint64_t replayCycles;
+
+#ifdef ARDUINO_ARCH_SAMD
+// With GPS_COUNT_ALLOCS, counts malloc() calls, operator new included,
+// so a replay can show the parsers never touch the heap. It replaces the
+// C library's malloc() and free(), so it's off unless asked for. Host
+// builds always count, in test/host/hw.cpp.
+volatile uint32_t heapAllocs = 0;
+#ifdef GPS_COUNT_ALLOCS
+extern "C" void *_malloc_r(struct _reent *r, size_t size);
+extern "C" void _free_r(struct _reent *r, void *ptr);
+
+extern "C" void *malloc(size_t size) {
+  heapAllocs++;
+  return _malloc_r(_REENT, size);
+}
+
+extern "C" void free(void *ptr) {
+  _free_r(_REENT, ptr);
+}
+#endif
+#endif
+
+// False if allocations aren't counted: GPS_COUNT_ALLOCS is off, or the
+// linker kept the C library's malloc() instead of ours.
+bool heapCounted() {
+  uint32_t before = heapAllocs;
+  void *volatile p = malloc(1);
+  free(p);
+  return heapAllocs != before;
+}
+
+// One line per sentence, raw integers, so runs can be diffed exactly.
+void printGpsFixCSV(const GpsFix &fix) {
+  SerialUSB.printf("FIX,%lu,%02d%02d%02d,%02d%02d%02d,%d,%d,%d,%ld,%ld,%ld,%d,%d,%d,%d,%d,%ld,%ld\n",
+                   gpsFixSeq, fix.hour, fix.minute, fix.second, fix.day, fix.month, fix.year,
+                   fix.valid, fix.mode, fix.quality, fix.position.latitude, fix.position.longitude, fix.altitude,
+                   fix.satsUsed, fix.satsInView, fix.pdop, fix.hdop, fix.vdop, fix.speed, fix.track);
+}
+
+void gpsReplayBegin(bool quiet) {
+  memset(&gpsFix, 0, sizeof(gpsFix));
+  gpsFixSeq = 0;
+  nmeaStatCount = 0;
+  gpsFramer.state = NMEA_IDLE;
+  gpsReplaying = true;
+  gpsReplayQuiet = quiet;
+  replayBytes = replaySentences = replayAllocs = 0;
+  replayCycles = 0;
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void gpsReplayEnd() {
+  gpsReplaying = false;
+  uint32_t perSentence = replaySentences ? replayCycles / replaySentences : 0;
+  SerialUSB.printf("REPLAY,%lu bytes,%lu sentences,%lu cycles/sentence,%lu sentences/s,",
+                   replayBytes, replaySentences, perSentence, perSentence ? F_CPU / perSentence : 0);
+  if (heapCounted()) SerialUSB.printf("%lu allocations\n", replayAllocs);
+  else SerialUSB.println("allocations not counted");
+  printNMEAStats();
+}
+
+// Frames one byte and keeps the per-type counters.
+uint8_t gpsFrame(char c) {
+  uint8_t rslt = nmeaFeed(gpsFramer, c);
+  if (rslt != NMEA_PENDING) countNMEA(gpsFramer.line, gpsFramer.len, rslt == NMEA_VALID);
+  return rslt;
+}
+
+void gpsReplayPoll() {
+  while (SerialUSB.available()) {
+    char c = SerialUSB.read();
+    if (c == 4) {
+      gpsReplayEnd();
+      return;
+    }
+    replayBytes++;
+    uint32_t allocs = heapAllocs, t0 = DWT->CYCCNT;
+    bool valid = gpsFrame(c) == NMEA_VALID;
+    if (valid) dispatchNMEA(gpsFramer.line, gpsFramer.len);
+    replayCycles += DWT->CYCCNT - t0;
+    replayAllocs += heapAllocs - allocs;
+    if (!valid) continue;
+    replaySentences++;
+    if (!gpsReplayQuiet) printGpsFixCSV(gpsFix);
+  }
+}
+
+// Called on every loop() pass: consumes whatever the GPS has sent so far
+// and never waits for more.
+void gpsPoll() {
+  if (gpsReplaying) {
+    gpsReplayPoll();
     return;
   }
-  Serial.print(" . PDOP: "); Serial.println(result.at(result.size() - 3).c_str());
-  Serial.print(" . HDOP: "); Serial.println(result.at(result.size() - 2).c_str());
-  Serial.print(" . VDOP: "); Serial.println(result.at(result.size() - 1).c_str());
+  uint8_t chunk[64];
+  size_t n;
+  while ((n = gps.readBytes(chunk, sizeof(chunk))) > 0) {
+    if (gpsRecording) SerialUSB.write(chunk, n);
+    for (size_t i = 0; i < n; i++)
+      if (gpsFrame(chunk[i]) == NMEA_VALID) nmeaPush(gpsQueue, gpsFramer.line, gpsFramer.len);
+  }
+  const nmeaLine *line;
+  while ((line = nmeaPop(gpsQueue)) != NULL)
+    dispatchNMEA(line->text, line->len);
+}
+
+// Receiver configuration. By default the receiver streams every sentence
+// it knows at power-on speed, and each byte costs the bit-banged port a
+// full byte time. We only ask for what the parsers use.
+// Families we know how to configure; GPS_CHIP_ANY sends every family's
+// commands, since receivers ignore sentences meant for other chips.
+#define GPS_CHIP_ANY 0
+#define GPS_CHIP_MTK 1 // $PMTK: Quectel L76/L80, GlobalTop, SIM28
+#define GPS_CHIP_CASIC 2 // $PCAS: AT6558, Air530 (Grove GPS)
+#define GPS_CHIP_UBLOX 3 // UBX-CFG: u-blox 6/7/8
+#ifndef GPS_CHIP
+#define GPS_CHIP GPS_CHIP_ANY
+#endif
+#define GPS_BAUD 9600 // assumed power-on speed if detection fails
+#define GPS_TARGET_BAUD 9600 // minimum: 19200, 38400, 57600 or 115200 to shorten sentences on the wire
+long gpsBaud = GPS_BAUD; // receiver's current speed
+#define GPS_RATE_MS 1000 // fix interval
+#define GPS_GSV_EVERY 5 // GSV once every n fixes, 0 for none
+
+void gpsSendNMEA(const char *body) {
+  uint8_t checksum = 0;
+  for (const char *p = body; *p; p++) checksum ^= *p;
+  char tmp[96];
+  sprintf(tmp, "$%s*%02X\r\n", body, checksum);
+  gps.print(tmp);
+}
+
+void gpsSendUBX(uint8_t msgClass, uint8_t msgId, const uint8_t *payload, uint16_t len) {
+  uint8_t header[6] = {0xB5, 0x62, msgClass, msgId, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+  uint8_t ckA = 0, ckB = 0;
+  for (uint8_t i = 2; i < 6; i++) {
+    ckA += header[i];
+    ckB += ckA;
+  }
+  for (uint16_t i = 0; i < len; i++) {
+    ckA += payload[i];
+    ckB += ckA;
+  }
+  gps.write(header, 6);
+  gps.write(payload, len);
+  gps.write(ckA);
+  gps.write(ckB);
+}
+
+void configureMTK() {
+  char tmp[64];
+  // GLL, RMC, VTG, GGA, GSA, GSV, then unused/proprietary sentences
+  sprintf(tmp, "PMTK314,0,1,0,1,0,%d,0,0,0,0,0,0,0,0,0,0,0,0,0", GPS_GSV_EVERY);
+  gpsSendNMEA(tmp);
+  sprintf(tmp, "PMTK220,%d", GPS_RATE_MS);
+  gpsSendNMEA(tmp);
+  if (GPS_TARGET_BAUD > gpsBaud) {
+    sprintf(tmp, "PMTK251,%ld", (long)GPS_TARGET_BAUD);
+    gpsSendNMEA(tmp);
+  }
+}
+
+void configureCASIC() {
+  char tmp[64];
+  // GGA, GLL, GSA, GSV, RMC, VTG, ZDA, ANT
+  sprintf(tmp, "PCAS03,1,0,0,%d,1,0,0,0", GPS_GSV_EVERY);
+  gpsSendNMEA(tmp);
+  sprintf(tmp, "PCAS02,%d", GPS_RATE_MS);
+  gpsSendNMEA(tmp);
+  if (GPS_TARGET_BAUD > gpsBaud) {
+    const long rates[] = {4800, 9600, 19200, 38400, 57600, 115200};
+    for (uint8_t i = 0; i < 6; i++) {
+      if (rates[i] != GPS_TARGET_BAUD) continue;
+      sprintf(tmp, "PCAS01,%d", i);
+      gpsSendNMEA(tmp);
+    }
+  }
+}
+
+void configureUBX() {
+  // CFG-MSG: NMEA (class F0) GGA 00, GLL 01, GSA 02, GSV 03, RMC 04, VTG 05
+  const uint8_t rates[6] = {1, 0, 0, GPS_GSV_EVERY, 1, 0};
+  for (uint8_t id = 0; id < 6; id++) {
+    uint8_t msg[3] = {0xF0, id, rates[id]};
+    gpsSendUBX(0x06, 0x01, msg, 3);
+  }
+  // CFG-RATE: measRate, navRate 1, timeRef UTC
+  uint8_t rate[6] = {GPS_RATE_MS & 0xFF, GPS_RATE_MS >> 8, 1, 0, 0, 0};
+  gpsSendUBX(0x06, 0x08, rate, 6);
+  if (GPS_TARGET_BAUD > gpsBaud) {
+    // CFG-PRT: UART1, 8N1, UBX+NMEA in, NMEA out
+    uint32_t baud = GPS_TARGET_BAUD;
+    uint8_t port[20] = {
+      1, 0, 0, 0, 0xD0, 0x08, 0, 0,
+      (uint8_t)baud, (uint8_t)(baud >> 8), (uint8_t)(baud >> 16), (uint8_t)(baud >> 24),
+      0x03, 0, 0x02, 0, 0, 0, 0, 0
+    };
+    gpsSendUBX(0x06, 0x00, port, 20);
+  }
+}
+
+// Valid sentences received in ms at the port's current speed. Whatever
+// was buffered before is dropped first: sentences that arrived at the
+// old speed would vouch for the new one.
+uint8_t scoreGpsBaud(uint32_t ms) {
+  nmeaFramer framer = {{0}, 0, NMEA_IDLE, 0, 0};
+  uint8_t valid = 0;
+  while (gps.read() >= 0);
+  uint32_t t0 = millis();
+  while (millis() - t0 < ms) {
+    int c = gps.read();
+    if (c >= 0 && nmeaFeed(framer, c) == NMEA_VALID) valid++;
+  }
+  return valid;
+}
+
+// Times the line first, then checks for real sentences at that speed.
+// If that fails, tries each rate in turn, most common first: a receiver
+// sending nothing yet, or a glitchy line, still gets found.
+long detectGpsBaud() {
+  const long rates[] = {9600, 38400, 115200, 4800, 19200, 57600};
+  long rate = gps.autobaud();
+  SerialUSB.printf("GPS autobaud: %ld\n", rate);
+  if (rate && scoreGpsBaud(1100)) return rate;
+  for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+    if (rates[i] == rate) continue;
+    gps.begin(rates[i]);
+    if (scoreGpsBaud(1100)) return rates[i];
+  }
+  return 0;
+}
+
+void configureGPS() {
+  if (GPS_CHIP == GPS_CHIP_ANY || GPS_CHIP == GPS_CHIP_MTK) configureMTK();
+  if (GPS_CHIP == GPS_CHIP_ANY || GPS_CHIP == GPS_CHIP_CASIC) configureCASIC();
+  if (GPS_CHIP == GPS_CHIP_ANY || GPS_CHIP == GPS_CHIP_UBLOX) configureUBX();
+  if (GPS_TARGET_BAUD > gpsBaud) {
+    // Let the last command leave our TX buffer, then the receiver's UART,
+    // before it switches.
+    gps.flush();
+    delay(100);
+    gps.begin(GPS_TARGET_BAUD);
+    if (scoreGpsBaud(1100)) gpsBaud = GPS_TARGET_BAUD;
+    else {
+      // Didn't take: back to where it was.
+      SerialUSB.printf("GPS didn't switch to %ld\n", (long)GPS_TARGET_BAUD);
+      gps.begin(gpsBaud);
+    }
+  }
 }
 
 void initGPS() {
   SerialUSB.println("============");
   SerialUSB.println(" GPS Setup");
   SerialUSB.println("============");
-  gps.begin(9600);
+  gps.begin(GPS_BAUD);
   gps.listen();
-  lastGPS = millis();
+  gpsBaud = detectGpsBaud();
+  if (gpsBaud == 0) {
+    gpsBaud = GPS_BAUD;
+    gps.begin(gpsBaud);
+    SerialUSB.printf("No GPS sentences, assuming %ld\n", gpsBaud);
+  } else SerialUSB.printf("GPS at %ld\n", gpsBaud);
+  configureGPS();
+}
+
+// Link sweep: how fast can a SoftwareSerial port go before bytes go bad?
+// Needs a jumper from SWEEP_TX_PIN to SWEEP_RX_PIN. One port sends
+// blocks of bytes, optionally off speed by txPpm, another receives them
+// at each rate, with each engine. The GPS port is restored afterwards.
+#define SWEEP_RX_PIN 1
+#define SWEEP_TX_PIN 0
+#define SWEEP_BYTES 2048
+#define SWEEP_BLOCK 32
+
+void sweepLink(long txPpm) {
+  const long rates[] = {9600, 19200, 38400, 57600, 115200};
+  const uint8_t engines[] = {SS_RX_BUSYWAIT, SS_RX_TIMER};
+  // Both own SWEEP_TX_PIN, but only the sender ever writes.
+  SoftwareSerialT<2, 64> sender(SWEEP_RX_PIN, SWEEP_TX_PIN);
+  SoftwareSerialT<128> receiver(SWEEP_RX_PIN, SWEEP_TX_PIN);
+  uint8_t engine = gps.rxEngine();
+  SerialUSB.printf("Loopback D%d -> D%d, TX asked to run %ld ppm off\n", SWEEP_TX_PIN, SWEEP_RX_PIN, txPpm);
+  SerialUSB.println("engine    baud  tx baud  tx ppm  errors  framing  dropped   max jitter  cycles/byte");
+  for (uint8_t e = 0; e < 2; e++) {
+    for (uint8_t r = 0; r < 5; r++) {
+      sender.begin(rates[r] + (long long)rates[r] * txPpm / 1000000);
+      receiver.setRxEngine(engines[e]);
+      receiver.begin(rates[r]);
+      receiver.resetRxStats();
+      receiver.resetRxCycles();
+      uint8_t sent[SWEEP_BLOCK], got[SWEEP_BLOCK * 2];
+      uint32_t errors = 0, seed = 1;
+      for (uint16_t n = 0; n < SWEEP_BYTES; n += SWEEP_BLOCK) {
+        for (uint8_t i = 0; i < SWEEP_BLOCK; i++) {
+          seed = seed * 1103515245 + 12345;
+          sent[i] = seed >> 16;
+        }
+        sender.write(sent, SWEEP_BLOCK);
+        sender.flush();
+        // The last stop bit, and then some.
+        delayMicroseconds(20000000 / rates[r]);
+        size_t count = receiver.readBytes(got, sizeof(got));
+        for (uint8_t i = 0; i < SWEEP_BLOCK && i < count; i++)
+          if (got[i] != sent[i]) errors++;
+        errors += count > SWEEP_BLOCK ? count - SWEEP_BLOCK : SWEEP_BLOCK - count;
+      }
+      SoftwareSerialStats st;
+      receiver.rxStats(st);
+      // The receiver falls back to busy-wait below the timer's range. The
+      // TX timer only has 48 MHz ticks: at 115200 bps one tick is ~2400
+      // ppm, so show the rate it really sent.
+      long txBaud = sender.txBaud();
+      SerialUSB.printf("%-8s %6ld  %7ld  %+6ld  %6lu  %7lu  %7lu  %11lu  %11lu\n", receiver.rxEngine() == SS_RX_TIMER ? "timer" : "busywait",
+                       rates[r], txBaud, (long)((long long)(txBaud - rates[r]) * 1000000 / rates[r]),
+                       errors, st.framingErrors, st.dropped, st.maxJitter, receiver.rxCyclesPerByte());
+    }
+  }
+  receiver.end();
+  gps.setRxEngine(engine);
+  gps.begin(gpsBaud);
 }
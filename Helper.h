@@ -31,8 +31,8 @@ bool deviceConnected = false;
 bool oldDeviceConnected = false;
 char deviceName[32] = "WioE5_0123456789abcde";
 LGFX lcd;
-unsigned char inBuffer[512] = {0};
 uint32_t pingCount = 0;
+uint32_t loraConfigs = 0; // bumped each time initLoRaSettings() runs
 
 #define SERVICE_UUID "6E400001-B5A3-F393-E0A9-E50E24DCCA9E" // UART service UUID
 #define CHARACTERISTIC_UUID_RX "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
@@ -42,17 +42,14 @@ uint32_t pingCount = 0;
 uint16_t prevx, prevy;
 uint8_t mySFs[6] = {7, 8, 9, 10, 11, 12};
 uint8_t mySF = 5;
-uint8_t myBWs[3] = {125, 250, 500};
+uint16_t myBWs[3] = {125, 250, 500};
 uint8_t myBW = 0;
 float myFreq = 868.0;
 uint8_t myTx = 20, myFreqIndex = 5;
 
-struct myDetails {
-  char magic[5]; // @love 5
-  uint8_t sfbwtx[3]; // 3
-  float freq; // 4
-  // Total: 12
-};
+uint8_t myPreamble = 8;
+uint16_t myPingInterval = 30; // s
+uint8_t luminosity = 128;
 
 static void lineTo(uint16_t x, uint16_t y, uint16_t color) {
   lcd.drawLine( prevx, prevy, x, y, color);
@@ -115,38 +112,6 @@ class MyCallbacks: public BLECharacteristicCallbacks {
     }
 };
 
-void hexDump(uint8_t* buf, uint16_t len) {
-  // Something similar to the Unix/Linux hexdump -C command
-  // Pretty-prints the contents of a buffer, 16 bytes a row
-  char alphabet[17] = "0123456789abcdef";
-  uint16_t i, index;
-  SerialUSB.print(F("   +------------------------------------------------+ +----------------+\n"));
-  SerialUSB.print(F("   |.0 .1 .2 .3 .4 .5 .6 .7 .8 .9 .a .b .c .d .e .f | |      ASCII     |\n"));
-  for (i = 0; i < len; i += 16) {
-    if (i % 128 == 0) SerialUSB.print(F("   +------------------------------------------------+ +----------------+\n"));
-    char s[] = "|                                                | |                |\n";
-    // pre-formated line. We will replace the spaces with text when appropriate.
-    uint8_t ix = 1, iy = 52, j;
-    for (j = 0; j < 16; j++) {
-      if (i + j < len) {
-        uint8_t c = buf[i + j];
-        // fastest way to convert a byte to its 2-digit hex equivalent
-        s[ix++] = alphabet[(c >> 4) & 0x0F];
-        s[ix++] = alphabet[c & 0x0F];
-        ix++;
-        if (c > 31 && c < 128) s[iy++] = c;
-        else s[iy++] = '.'; // display ASCII code 0x20-0x7F or a dot.
-      }
-    }
-    index = i >> 4;
-    // display line number then the text
-    if (i < 256) Serial.write(' ');
-    SerialUSB.print(index, HEX); Serial.write('.');
-    SerialUSB.print(s);
-  }
-  SerialUSB.print(F("   +------------------------------------------------+ +----------------+\n"));
-}
-
 void ble_setup() {
   SerialUSB.println("============");
   SerialUSB.println(" BLE Setup");
@@ -188,24 +153,9 @@ void initLoRaSettings() {
   SerialUSB.println("=============");
   SerialUSB.println(" LoRa Setup");
   SerialUSB.println("=============");
-  lora.initP2PMode(myFreq, (_spreading_factor_t)mySFs[mySF], (_band_width_t)myBWs[myBW], 8, 8, myTx);
+  lora.initP2PMode(myFreq, (_spreading_factor_t)mySFs[mySF], (_band_width_t)myBWs[myBW], myPreamble, myPreamble, myTx);
   delay(100);
-}
-
-void hex2array(char *src, size_t sLen, char *dst) {
-  size_t i, n = 0;
-  for (i = 0; i < sLen; i += 2) {
-    uint8_t x, c;
-    c = src[i];
-    if (c > 0x39) c -= 55;
-    else c -= 0x30;
-    x = c << 4;
-    c = src[i + 1];
-    if (c > 0x39) c -= 55;
-    else c -= 0x30;
-    dst[n++] = (x + c);
-  }
-  dst[n] = 0;
+  loraConfigs++;
 }
 
 void notifyBLE(char* myString) {
@@ -216,96 +166,242 @@ void notifyBLE(char* myString) {
   }
 }
 
-void setEEPROM(uint8_t addr, uint8_t v) {
-  Serial1.flush();
-  delay(10);
-  while (Serial1.available()) {
-    char c = Serial1.read();
-    delay(5);
+// Prefs live in the E5's EEPROM, 224-255, as one prefsRecord.
+// prefsShadow mirrors what's there, so a flush only writes the bytes
+// that changed. savePrefs() just marks them dirty: menu changes in quick
+// succession make one flush, PREFS_DEBOUNCE ms after the last one. The
+// flush queues its writes on the AT engine and doesn't wait for them.
+#define PREFS_ADDR 224
+#define PREFS_LEN 32
+#define PREFS_VERSION 1
+#define PREFS_DEBOUNCE 2000
+uint8_t prefsShadow[PREFS_LEN];
+bool prefsShadowValid = false;
+bool prefsDirty = false;
+uint32_t prefsDirtyAt;
+// Set when the stored record couldn't be read, or is a version this
+// firmware doesn't know: the settings then live in RAM only, and the
+// record is never written over.
+bool prefsLocked = false;
+#define PREFS_READ_TRIES 2
+
+// Reserved bytes are for new fields: take them, bump PREFS_VERSION and
+// give the new fields their defaults in migratePrefs().
+struct __attribute__((packed)) prefsRecord {
+  char magic[4]; // "@lov"
+  uint8_t version;
+  uint8_t length; // sizeof(prefsRecord) when written
+  uint8_t sf, bw;
+  float freq;
+  uint8_t tx, freqIndex;
+  uint8_t preamble, unused0; // was the coding rate, which the E5 can't set
+  uint8_t brightness, reserved0;
+  uint16_t pingInterval; // s
+  uint8_t reserved[10];
+  uint16_t crc; // CRC-16/CCITT of everything above
+};
+static_assert(sizeof(prefsRecord) == PREFS_LEN, "prefsRecord must fill PREFS_LEN");
+
+// The first layout, 16 bytes at 240: the second half of the record's
+// space. Only read, to migrate it.
+struct __attribute__((packed)) legacyPrefs {
+  char magic[5]; // "@love"
+  uint8_t sf, bw, tx;
+  float freq;
+  uint8_t freqIndex;
+  uint8_t unused[3];
+};
+
+uint16_t crc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+void buildPrefs(uint8_t *prefs) {
+  prefsRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  memcpy(rec.magic, "@lov", 4);
+  rec.version = PREFS_VERSION;
+  rec.length = sizeof(rec);
+  rec.sf = mySF;
+  rec.bw = myBW;
+  rec.freq = myFreq;
+  rec.tx = myTx;
+  rec.freqIndex = myFreqIndex;
+  rec.preamble = myPreamble;
+  rec.brightness = luminosity;
+  rec.pingInterval = myPingInterval;
+  rec.crc = crc16((uint8_t*)&rec, offsetof(prefsRecord, crc));
+  memcpy(prefs, &rec, PREFS_LEN);
+}
+
+void applyPrefs(const prefsRecord &rec) {
+  mySF = rec.sf;
+  myBW = rec.bw;
+  myFreq = rec.freq;
+  myTx = rec.tx;
+  myFreqIndex = rec.freqIndex;
+  myPreamble = rec.preamble;
+  luminosity = rec.brightness;
+  myPingInterval = rec.pingInterval;
+}
+
+// Brings a record written by older firmware up to PREFS_VERSION, one
+// version at a time, e.g.
+//   case 1: rec.newField = default; // fall through
+// False for a version this firmware doesn't know.
+bool migratePrefs(prefsRecord &rec) {
+  switch (rec.version) {
+    case PREFS_VERSION:
+      return true;
   }
-  uint8_t n;
-  char tmp[32];
-  sprintf(tmp, "AT+EEPROM=%02x,%02x\r\n", addr, v);
-  Serial1.print(tmp);
-  delay(100);
-  memset(tmp, 0, 32);
-  char c = 0;
-  n = 0;
-  while (c != 10 && n < 32) {
-    c = Serial1.read();
-    if (c > 31) tmp[n++] = c;
-    delay(10);
+  return false;
+}
+
+// The flush in progress: the record being written, the next byte to
+// queue, and the answers still due.
+uint8_t prefsImage[PREFS_LEN];
+bool prefsFlushing = false;
+uint8_t prefsNext, prefsWritesLeft, prefsWritten, prefsWritesFailed;
+uint32_t prefsFlushAt;
+// savePrefs() calls, in all and when the flush began
+uint32_t prefsSaves = 0, prefsFlushSaves;
+
+bool prefsByteChanged(uint8_t ix) {
+  return !prefsShadowValid || prefsImage[ix] != prefsShadow[ix];
+}
+
+// prefsShadow only takes a byte once the E5 has acknowledged it, so a
+// failed flush is retried PREFS_DEBOUNCE ms later, for what's left.
+void prefsFlushDone() {
+  prefsFlushing = false;
+  if (prefsWritesFailed == 0) prefsShadowValid = true;
+  if (prefsWritesFailed == 0 && prefsSaves == prefsFlushSaves) prefsDirty = false;
+  else prefsDirtyAt = millis();
+  SerialUSB.printf("Prefs: %d byte%s written in %lu ms", prefsWritten, prefsWritten == 1 ? "" : "s", millis() - prefsFlushAt);
+  if (prefsWritesFailed) SerialUSB.printf(", %d failed, will retry", prefsWritesFailed);
+  SerialUSB.println();
+}
+
+void prefsByteWritten(uint8_t result, const char *line, void *ctx) {
+  uint8_t ix = (uintptr_t)ctx;
+  if (result == AT_OK) {
+    prefsShadow[ix] = prefsImage[ix];
+    prefsWritten++;
+  } else {
+    SerialUSB.printf("EEPROM %02x: write failed\n", PREFS_ADDR + ix);
+    prefsWritesFailed++;
   }
-  SerialUSB.println(tmp);
-  return;
+  if (--prefsWritesLeft == 0) prefsFlushDone();
 }
 
-uint8_t getEEPROM(uint8_t addr) {
-  /*
-    AT+EEPROM=00,40
-    AT+EEPROM=01,6C
-    AT+EEPROM=02,6F
-    AT+EEPROM=03,76
-    AT+EEPROM=04,65
-  */
-  Serial1.flush();
-  delay(10);
-  while (Serial1.available()) {
-    char c = Serial1.read();
-    delay(5);
+// Queues as many of the writes as the AT queue takes now; pollPrefs()
+// queues the rest as it drains.
+void prefsQueueWrites() {
+  char cmd[24];
+  for (; prefsNext < PREFS_LEN; prefsNext++) {
+    if (!prefsByteChanged(prefsNext)) continue;
+    sprintf(cmd, "AT+EEPROM=%02x,%02x", PREFS_ADDR + prefsNext, prefsImage[prefsNext]);
+    if (!atSend(cmd, prefsByteWritten, (void*)(uintptr_t)prefsNext)) return;
   }
-  uint8_t n;
-  char tmp[32];
-  sprintf(tmp, "AT+EEPROM=%02x\r\n", addr);
-  Serial1.print(tmp);
-  delay(100);
-  memset(tmp, 0, 32);
-  char c = 0;
-  n = 0;
-  bool done = false;
-  while (c != 10 && n < 32) {
-    c = Serial1.read();
-    if (c > 31) tmp[n++] = c;
-    done = true;
-    delay(10);
+}
+
+void flushPrefs() {
+  buildPrefs(prefsImage);
+  prefsFlushing = true;
+  prefsFlushAt = millis();
+  prefsFlushSaves = prefsSaves;
+  prefsNext = prefsWritesLeft = prefsWritten = prefsWritesFailed = 0;
+  for (uint8_t ix = 0; ix < PREFS_LEN; ix++)
+    if (prefsByteChanged(ix)) prefsWritesLeft++;
+  if (prefsWritesLeft == 0) prefsFlushDone();
+  else prefsQueueWrites();
+}
+
+void savePrefs() {
+  prefsDirty = true;
+  prefsDirtyAt = millis();
+  prefsSaves++;
+}
+
+void pollPrefs() {
+  if (prefsLocked) return;
+  if (prefsFlushing) prefsQueueWrites();
+  else if (prefsDirty && millis() - prefsDirtyAt > PREFS_DEBOUNCE) flushPrefs();
+}
+
+uint8_t prefsReadsLeft, prefsReadsFailed;
+
+// Each answer carries its address: +EEPROM: E0, 40. A timeout passes an
+// empty line, and an error or a bare OK has no address: check first.
+void prefsByteRead(uint8_t result, const char *line, void *ctx) {
+  prefsReadsLeft--;
+  if (result != AT_OK || !startsWith(line, "+EEPROM: ")) {
+    prefsReadsFailed++;
+    return;
   }
-  if (done == false) {
-    tmp[n] = 0;
-    SerialUSB.printf("Failed to get full sentence! []\n", tmp);
-    return 0xFF;
+  char *end;
+  unsigned long addr = strtoul(line + 9, &end, 16);
+  if (*end != ',' || addr < PREFS_ADDR || addr >= PREFS_ADDR + PREFS_LEN) {
+    prefsReadsFailed++;
+    return;
   }
-  // SerialUSB.println(tmp);
-  char *ptr = strstr(tmp, "+EEPROM: ");
-  // +EEPROM: 01, 00
-  if (ptr) {
-    // set value
-    n = 9;
-    tmp[0] = ptr[n++];
-    tmp[1] = ptr[n];
-    n += 3;
-    tmp[2] = ptr[n++];
-    tmp[3] = ptr[n];
-    hex2array(tmp, 4, tmp + 4);
-    // hexDump((uint8_t*)tmp, 6);
-    uint8_t k, v;
-    k = tmp[4]; v = tmp[5];
-    // SerialUSB.printf(" --> buffer[%02x] = buffer[%02x]\n", k, v);
-    return v;
-  } else return 0xFF;
+  prefsShadow[addr - PREFS_ADDR] = strtoul(end + 1, NULL, 16);
 }
 
-void savePrefs(float freq = myFreq, uint8_t sf = mySF, uint8_t bw = myBW, uint8_t tx = myTx) {
-  SerialUSB.println("Saving Prefs...");
-  uint8_t prefs[16] = {
-    '@', 'l', 'o', 'v', 'e',
-    mySF, myBW, myTx,
-    0, 0, 0, 0,
-    myFreqIndex, 0, 0, 0
-  };
-  memcpy(prefs + 8, (uint8_t*)&myFreq, 4);
-  hexDump(prefs, 16);
-  for (uint8_t ix = 0; ix < 16; ix++) {
-    lora.setEEPROM(240 + ix, prefs[ix]);
-    delay(100);
+// The E5 reads one EEPROM byte per command, so the whole record goes in
+// one pass: all reads queued back to back, no sleeping in between.
+bool readPrefsImage() {
+  char cmd[16];
+  prefsReadsLeft = PREFS_LEN;
+  prefsReadsFailed = 0;
+  for (uint8_t ix = 0; ix < PREFS_LEN; ix++) {
+    sprintf(cmd, "AT+EEPROM=%02x", PREFS_ADDR + ix);
+    while (!atSend(cmd, prefsByteRead)) atPoll();
+  }
+  while (prefsReadsLeft) atPoll();
+  return prefsReadsFailed == 0;
+}
+
+// Reads the EEPROM into the shadow and the settings from it: the
+// current record, an older one migrated, or the legacy layout. Writes
+// the record back only if it was migrated, or its magic or CRC was
+// wrong; a record it can't read or doesn't know is left alone.
+void loadPrefs() {
+  uint32_t t0 = millis();
+  for (uint8_t i = 0; i < PREFS_READ_TRIES && !prefsShadowValid; i++) prefsShadowValid = readPrefsImage();
+  SerialUSB.printf("Prefs read in %lu ms\n", millis() - t0);
+  if (!prefsShadowValid) {
+    SerialUSB.println("Prefs unreadable, using defaults. Changes won't be saved.");
+    prefsLocked = true;
+    return;
+  }
+  hexDump(prefsShadow, PREFS_LEN);
+  prefsRecord rec;
+  memcpy(&rec, prefsShadow, PREFS_LEN);
+  const legacyPrefs *legacy = (const legacyPrefs*)(prefsShadow + 16);
+  if (memcmp(rec.magic, "@lov", 4) == 0 && rec.crc == crc16(prefsShadow, offsetof(prefsRecord, crc))) {
+    uint8_t version = rec.version;
+    if (migratePrefs(rec)) {
+      applyPrefs(rec);
+      if (version != PREFS_VERSION) flushPrefs();
+      return;
+    }
+    SerialUSB.printf("Prefs version %d unknown, using defaults. Changes won't be saved.\n", version);
+    prefsLocked = true;
+    return;
+  } else if (memcmp(legacy->magic, "@love", 5) == 0) {
+    SerialUSB.println("Migrating old prefs");
+    mySF = legacy->sf;
+    myBW = legacy->bw;
+    myTx = legacy->tx;
+    myFreq = legacy->freq;
+    myFreqIndex = legacy->freqIndex;
   }
+  flushPrefs();
 }
@@ -0,0 +1,172 @@
+/*
+  Wio_Terminal_E5_LoRa_Tx. A demonstration of two-way LoRa communication
+  between two (or more) Wio Terminal devices equipped with Wio-E5.
+  Copyright (C) 2023 by Kongduino
+  kongduino@protonmail.com https://github.com/Kongduino
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  For commercial and/or closed-source usage and licensing, please contact the author.
+*/
+
+// Hex codec for the E5 link (payloads travel as hex in AT commands and
+// URCs), NMEA checksums and USB dumps. Table-driven: no branches per
+// nibble. Word-at-a-time paths assume a little-endian CPU, as the SAMD51
+// is.
+
+#define HEX_INVALID 0xFF
+// Value of each character as a hex digit, either case; HEX_INVALID if
+// it isn't one.
+const uint8_t hexTable[256] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// Each byte's two uppercase digits, first digit in the low byte: stored
+// little-endian, they land in order.
+const uint16_t hexPairs[256] = {
+  0x3030, 0x3130, 0x3230, 0x3330, 0x3430, 0x3530, 0x3630, 0x3730,
+  0x3830, 0x3930, 0x4130, 0x4230, 0x4330, 0x4430, 0x4530, 0x4630,
+  0x3031, 0x3131, 0x3231, 0x3331, 0x3431, 0x3531, 0x3631, 0x3731,
+  0x3831, 0x3931, 0x4131, 0x4231, 0x4331, 0x4431, 0x4531, 0x4631,
+  0x3032, 0x3132, 0x3232, 0x3332, 0x3432, 0x3532, 0x3632, 0x3732,
+  0x3832, 0x3932, 0x4132, 0x4232, 0x4332, 0x4432, 0x4532, 0x4632,
+  0x3033, 0x3133, 0x3233, 0x3333, 0x3433, 0x3533, 0x3633, 0x3733,
+  0x3833, 0x3933, 0x4133, 0x4233, 0x4333, 0x4433, 0x4533, 0x4633,
+  0x3034, 0x3134, 0x3234, 0x3334, 0x3434, 0x3534, 0x3634, 0x3734,
+  0x3834, 0x3934, 0x4134, 0x4234, 0x4334, 0x4434, 0x4534, 0x4634,
+  0x3035, 0x3135, 0x3235, 0x3335, 0x3435, 0x3535, 0x3635, 0x3735,
+  0x3835, 0x3935, 0x4135, 0x4235, 0x4335, 0x4435, 0x4535, 0x4635,
+  0x3036, 0x3136, 0x3236, 0x3336, 0x3436, 0x3536, 0x3636, 0x3736,
+  0x3836, 0x3936, 0x4136, 0x4236, 0x4336, 0x4436, 0x4536, 0x4636,
+  0x3037, 0x3137, 0x3237, 0x3337, 0x3437, 0x3537, 0x3637, 0x3737,
+  0x3837, 0x3937, 0x4137, 0x4237, 0x4337, 0x4437, 0x4537, 0x4637,
+  0x3038, 0x3138, 0x3238, 0x3338, 0x3438, 0x3538, 0x3638, 0x3738,
+  0x3838, 0x3938, 0x4138, 0x4238, 0x4338, 0x4438, 0x4538, 0x4638,
+  0x3039, 0x3139, 0x3239, 0x3339, 0x3439, 0x3539, 0x3639, 0x3739,
+  0x3839, 0x3939, 0x4139, 0x4239, 0x4339, 0x4439, 0x4539, 0x4639,
+  0x3041, 0x3141, 0x3241, 0x3341, 0x3441, 0x3541, 0x3641, 0x3741,
+  0x3841, 0x3941, 0x4141, 0x4241, 0x4341, 0x4441, 0x4541, 0x4641,
+  0x3042, 0x3142, 0x3242, 0x3342, 0x3442, 0x3542, 0x3642, 0x3742,
+  0x3842, 0x3942, 0x4142, 0x4242, 0x4342, 0x4442, 0x4542, 0x4642,
+  0x3043, 0x3143, 0x3243, 0x3343, 0x3443, 0x3543, 0x3643, 0x3743,
+  0x3843, 0x3943, 0x4143, 0x4243, 0x4343, 0x4443, 0x4543, 0x4643,
+  0x3044, 0x3144, 0x3244, 0x3344, 0x3444, 0x3544, 0x3644, 0x3744,
+  0x3844, 0x3944, 0x4144, 0x4244, 0x4344, 0x4444, 0x4544, 0x4644,
+  0x3045, 0x3145, 0x3245, 0x3345, 0x3445, 0x3545, 0x3645, 0x3745,
+  0x3845, 0x3945, 0x4145, 0x4245, 0x4345, 0x4445, 0x4545, 0x4645,
+  0x3046, 0x3146, 0x3246, 0x3346, 0x3446, 0x3546, 0x3646, 0x3746,
+  0x3846, 0x3946, 0x4146, 0x4246, 0x4346, 0x4446, 0x4546, 0x4646
+};
+
+uint8_t hexValue(char c) {
+  return hexTable[(uint8_t)c];
+}
+
+// Decodes len hex characters into dst. Returns the number of bytes, or
+// -1 if len is odd or a character isn't hex.
+int hexDecode(const char *src, size_t len, uint8_t *dst) {
+  if (len & 1) return -1;
+  for (size_t i = 0; i < len; i += 2) {
+    uint8_t hi = hexTable[(uint8_t)src[i]], lo = hexTable[(uint8_t)src[i + 1]];
+    if ((hi | lo) & 0xF0) return -1;
+    *dst++ = (hi << 4) | lo;
+  }
+  return len / 2;
+}
+
+// Writes 2 * len uppercase digits and a NUL, and returns the end. Four
+// bytes at a time: one load, then eight digits in two stores.
+char *hexEncode(const uint8_t *src, size_t len, char *dst) {
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    uint32_t w;
+    memcpy(&w, src + i, 4);
+    uint32_t a = hexPairs[w & 0xFF] | (uint32_t)hexPairs[(w >> 8) & 0xFF] << 16;
+    uint32_t b = hexPairs[(w >> 16) & 0xFF] | (uint32_t)hexPairs[w >> 24] << 16;
+    memcpy(dst, &a, 4);
+    memcpy(dst + 4, &b, 4);
+    dst += 8;
+  }
+  for (; i < len; i++) {
+    memcpy(dst, &hexPairs[src[i]], 2);
+    dst += 2;
+  }
+  *dst = 0;
+  return dst;
+}
+
+// Something similar to the Unix/Linux hexdump -C command: 16 bytes a row.
+#define HEX_DUMP_ROW 74 // at most, per row, newline included
+const char hexDumpBorder[] = "   +------------------------------------------------+ +----------------+\n";
+const char hexDumpHeader[] = "   |.0 .1 .2 .3 .4 .5 .6 .7 .8 .9 .a .b .c .d .e .f | |      ASCII     |\n";
+
+// Formats row `row` of a dump of buf (bytes 16 * row on) into dst, and
+// returns the end. Not NUL-terminated.
+char *hexDumpRow(const uint8_t *buf, uint16_t len, uint16_t row, char *dst) {
+  char *p = dst;
+  if (row < 16) {
+    *p++ = ' ';
+    *p++ = hexPairs[row] >> 8;
+  } else p += sprintf(p, "%X", row);
+  *p++ = '.';
+  char *hex = p + 1, *ascii = p + 52;
+  memcpy(p, "|                                                | |                |\n", 70);
+  p += 70;
+  uint16_t i = row * 16;
+  for (uint8_t j = 0; j < 16 && i + j < len; j++) {
+    uint8_t c = buf[i + j];
+    memcpy(hex, &hexPairs[c], 2);
+    hex += 3;
+    *ascii++ = c > 31 && c < 128 ? c : '.';
+  }
+  return p;
+}
+
+void hexDump(uint8_t *buf, uint16_t len) {
+  // Rows go out a chunk at a time, not one print each.
+  char out[8 * HEX_DUMP_ROW + 2 * sizeof(hexDumpBorder)];
+  char *p = out;
+  SerialUSB.print(hexDumpBorder);
+  SerialUSB.print(hexDumpHeader);
+  for (uint16_t row = 0; row * 16 < len; row++) {
+    if (row % 8 == 0) {
+      memcpy(p, hexDumpBorder, sizeof(hexDumpBorder) - 1);
+      p += sizeof(hexDumpBorder) - 1;
+    }
+    p = hexDumpRow(buf, len, row, p);
+    if (p - out > (int)(sizeof(out) - HEX_DUMP_ROW - sizeof(hexDumpBorder))) {
+      SerialUSB.write(out, p - out);
+      p = out;
+    }
+  }
+  memcpy(p, hexDumpBorder, sizeof(hexDumpBorder) - 1);
+  p += sizeof(hexDumpBorder) - 1;
+  SerialUSB.write(out, p - out);
+}
@@ -0,0 +1,369 @@
+/*
+  Wio_Terminal_E5_LoRa_Tx. A demonstration of two-way LoRa communication
+  between two (or more) Wio Terminal devices equipped with Wio-E5.
+  Copyright (C) 2023 by Kongduino
+  kongduino@protonmail.com https://github.com/Kongduino
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+  For commercial and/or closed-source usage and licensing, please contact the author.
+*/
+
+// Transmit scheduler. Frames wait in a queue and go out only while the
+// sub-band's duty cycle budget allows: EU868 limits each sub-band to a
+// share of any hour, and at SF12 a few pings use it up. Time on air is
+// charged per minute over a sliding hour, in one-minute buckets. A frame
+// stays charged for 60 to 61 minutes, so the next one may wait up to a
+// minute longer than strictly needed, never less.
+
+// Semtech time on air (SX1276 datasheet, 4.1.1.7), in us. cr is 1-4
+// for 4/5-4/8. Explicit header, CRC on, as the E5 sends in test mode.
+uint32_t timeOnAir(uint16_t len, uint8_t sf, uint16_t bwKHz, uint8_t preamble, uint8_t cr) {
+  uint32_t symbol = (1000UL << sf) / bwKHz; // exact for 125/250/500 kHz
+  // Low data rate optimisation above 16 ms symbols.
+  uint8_t de = symbol > 16000 ? 1 : 0;
+  int32_t bits = 8 * len - 4 * sf + 28 + 16;
+  int32_t per = 4 * (sf - 2 * de);
+  int32_t payload = 8 + (bits > 0 ? (bits + per - 1) / per * (cr + 4) : 0);
+  // (preamble + 4.25 + payload) symbols
+  return symbol * (4 * (preamble + payload) + 17) / 4;
+}
+
+// AT+TEST=RFCFG has no coding rate: test mode always sends 4/5.
+#define E5_CODING_RATE 1
+
+uint32_t frameTimeOnAir(uint16_t len) {
+  return timeOnAir(len, mySFs[mySF], myBWs[myBW], myPreamble, E5_CODING_RATE);
+}
+
+// The current minute, and the 60 whole minutes before it.
+#define DUTY_BUCKETS 61
+struct dutyBand {
+  const char *name;
+  uint32_t lo, hi; // kHz
+  uint16_t tenths; // duty cycle, in 0.1%
+  uint16_t used[DUTY_BUCKETS]; // ms on air, per minute
+};
+// EU868 sub-bands, ETSI EN 300 220. The last entry catches the gaps
+// between them at the strictest limit. Outside 863-870 MHz there is no
+// budget.
+#define DUTY_BANDS 7
+dutyBand dutyBands[DUTY_BANDS] = {
+  {"863-865", 863000, 865000, 1, {0}},
+  {"865-868", 865000, 868000, 10, {0}},
+  {"868-868.6", 868000, 868600, 10, {0}},
+  {"868.7-869.2", 868700, 869200, 1, {0}},
+  {"869.4-869.65", 869400, 869650, 100, {0}},
+  {"869.7-870", 869700, 870000, 10, {0}},
+  {"EU868", 863000, 870000, 1, {0}},
+};
+uint8_t dutyBucket = 0; // the current minute's
+uint32_t dutyTick = 0; // millis() when it started
+
+dutyBand *dutyBandFor(float freq) {
+  uint32_t kHz = freq * 1000 + 0.5;
+  for (uint8_t i = 0; i < DUTY_BANDS; i++)
+    if (kHz >= dutyBands[i].lo && kHz < dutyBands[i].hi) return &dutyBands[i];
+  return NULL;
+}
+
+// Clears the buckets of minutes that left the hour. Counts minutes as
+// millis() differences, so its wrap after 49 days changes nothing.
+void dutyAdvance() {
+  uint32_t minutes = (millis() - dutyTick) / 60000;
+  if (minutes == 0) return;
+  dutyTick += minutes * 60000;
+  if (minutes >= DUTY_BUCKETS) {
+    for (uint8_t i = 0; i < DUTY_BANDS; i++) memset(dutyBands[i].used, 0, sizeof(dutyBands[i].used));
+    return;
+  }
+  while (minutes--) {
+    dutyBucket = (dutyBucket + 1) % DUTY_BUCKETS;
+    for (uint8_t i = 0; i < DUTY_BANDS; i++) dutyBands[i].used[dutyBucket] = 0;
+  }
+}
+
+uint32_t dutyUsed(const dutyBand *band) {
+  uint32_t ms = 0;
+  for (uint8_t i = 0; i < DUTY_BUCKETS; i++) ms += band->used[i];
+  return ms;
+}
+
+uint32_t dutyBudget(const dutyBand *band) {
+  return 3600UL * band->tenths;
+}
+
+void dutyCharge(dutyBand *band, uint32_t ms) {
+  uint16_t &bucket = band->used[dutyBucket];
+  bucket = bucket + ms > 0xFFFF ? 0xFFFF : bucket + ms;
+}
+
+// "868-868.6: 0.35% of 1%"
+char *formatDuty(char *dst) {
+  dutyAdvance();
+  dutyBand *band = dutyBandFor(myFreq);
+  if (band == NULL) {
+    sprintf(dst, "%.1f MHz: no duty cycle limit", myFreq);
+    return dst;
+  }
+  // Hundredths of a percent: ms * 10000 / 3600000
+  uint32_t used = dutyUsed(band) / 360;
+  sprintf(dst, "%s: %lu.%02lu%% of %u.%u%%", band->name, used / 100, used % 100, band->tenths / 10, band->tenths % 10);
+  return dst;
+}
+
+void printDuty() {
+  dutyAdvance();
+  SerialUSB.println("Duty cycle, last hour: used / budget ms");
+  for (uint8_t i = 0; i < DUTY_BANDS; i++)
+    SerialUSB.printf(" . %s: %lu / %lu\n", dutyBands[i].name, dutyUsed(&dutyBands[i]), dutyBudget(&dutyBands[i]));
+  char tmp[48];
+  SerialUSB.printf("Now on %s\n", formatDuty(tmp));
+}
+
+void drawDuty() {
+  char tmp[48];
+  formatDuty(tmp);
+  lcd.fillRect(40, 240 - 14, 160, 12, TFT_WHITE);
+  lcd.setTextColor(TFT_BLACK);
+  lcd.drawString(tmp, 40, 240 - 12, TT1);
+}
+
+// Ping frame, little-endian. 5 bytes, or 16 with a position:
+//   0     version << 4 | flags
+//   1-2   node ID
+//   3-4   sequence number
+//   5-8   latitude, degrees x 1e7
+//   9-12  longitude, degrees x 1e7
+//   13-14 altitude, m
+//   15    HDOP x 10
+#define PING_VERSION 1
+#define PING_POSITION 0x01 // the position block follows
+#define PING_3D 0x02 // altitude is valid
+#define PING_SHORT 5
+struct __attribute__((packed)) pingFrame {
+  uint8_t header;
+  uint16_t node, seq;
+  int32_t latitude, longitude;
+  int16_t altitude;
+  uint8_t hdop;
+};
+static_assert(sizeof(pingFrame) == 16, "pingFrame must stay 16 bytes");
+
+// SAMD51 128-bit serial number, folded to 16 bits.
+uint16_t nodeId() {
+  const uint32_t *words[4] = {(uint32_t*)0x008061FC, (uint32_t*)0x00806010, (uint32_t*)0x00806014, (uint32_t*)0x00806018};
+  uint8_t serial[16];
+  for (uint8_t i = 0; i < 4; i++) memcpy(serial + 4 * i, words[i], 4);
+  return crc16(serial, sizeof(serial));
+}
+
+// Returns the frame's length.
+uint8_t buildPing(pingFrame &f, uint16_t seq) {
+  static uint16_t node = nodeId();
+  GpsFix fix;
+  getGpsFix(fix);
+  memset(&f, 0, sizeof(f));
+  f.node = node;
+  f.seq = seq;
+  uint8_t flags = 0;
+  // From RMC and GGA: fix.mode would need GSA, which is off.
+  uint8_t mode = gpsFixMode(fix);
+  if (fix.valid && mode >= 2) {
+    flags |= PING_POSITION;
+    f.latitude = fix.position.latitude;
+    f.longitude = fix.position.longitude;
+    f.hdop = fix.hdop / 10 > 255 ? 255 : fix.hdop / 10;
+    if (mode == 3) {
+      flags |= PING_3D;
+      int32_t m = fix.altitude / 100;
+      f.altitude = m > 32767 ? 32767 : m < -32768 ? -32768 : m;
+    }
+  }
+  f.header = PING_VERSION << 4 | flags;
+  return flags & PING_POSITION ? sizeof(f) : PING_SHORT;
+}
+
+// False if data isn't a ping frame this version knows.
+bool decodePing(const uint8_t *data, uint16_t len, pingFrame &f) {
+  if (len != PING_SHORT && len != sizeof(f)) return false;
+  memset(&f, 0, sizeof(f));
+  memcpy(&f, data, len);
+  if (f.header >> 4 != PING_VERSION) return false;
+  return (len == sizeof(f)) == ((f.header & PING_POSITION) != 0);
+}
+
+// "Node 1A2B #42 22.3193748, 114.1694192 12m HDOP 0.9"
+char *formatPing(const pingFrame &f, char *dst) {
+  char *p = dst + sprintf(dst, "Node %04X #%u", f.node, f.seq);
+  if (f.header & PING_POSITION) {
+    char lat[16], lon[16];
+    p += sprintf(p, " %s, %s", formatDegrees(lat, f.latitude), formatDegrees(lon, f.longitude));
+    if (f.header & PING_3D) p += sprintf(p, " %dm", f.altitude);
+    sprintf(p, " HDOP %u.%u", f.hdop / 10, f.hdop % 10);
+  }
+  return dst;
+}
+
+// Radio manager. It owns the E5's mode: continuous RX by default, TX
+// for each queued frame, then RX again, all through the AT engine.
+// backgroundTasks() drives it, with the GPS and the prefs; every loop
+// that waits for the user calls it, so nothing is lost in the menus.
+#define RADIO_IDLE 0 // neither: RX is armed next
+#define RADIO_ARMING 1
+#define RADIO_RX 2
+#define RADIO_TX 3
+#define RADIO_RETRY_MS 1000
+#define RADIO_QUEUE_LEN 4
+#define RADIO_MAX_FRAME 64
+struct radioFrame {
+  uint8_t len;
+  uint8_t data[RADIO_MAX_FRAME];
+};
+// Called after each frame goes out, with its time on air.
+typedef void (*radioTxCallback)(uint32_t ms);
+
+radioFrame radioQueue[RADIO_QUEUE_LEN];
+uint8_t radioHead = 0, radioCount = 0;
+uint8_t radioState = RADIO_IDLE;
+bool radioDeferred = false;
+uint32_t radioRetryAt = 0, radioConfigs = 0;
+uint32_t radioSent = 0, radioReceived = 0, radioFailed = 0;
+uint8_t radioRxBuffer[256];
+atPacketCallback radioPacketHandler = NULL;
+radioTxCallback radioTxHandler = NULL;
+uint32_t pingTimer;
+
+// Queues a frame for radioPoll(). False if the queue is full.
+bool radioSend(const uint8_t *data, uint8_t len) {
+  if (radioCount == RADIO_QUEUE_LEN || len > RADIO_MAX_FRAME) return false;
+  radioFrame &f = radioQueue[(radioHead + radioCount) % RADIO_QUEUE_LEN];
+  memcpy(f.data, data, len);
+  f.len = len;
+  radioCount++;
+  return true;
+}
+
+// Received packets go to radioPacketHandler, or to the console and BLE
+// when no screen wants them.
+void radioPacket(const e5Packet &pkt) {
+  radioReceived++;
+  if (radioPacketHandler) {
+    radioPacketHandler(pkt);
+    return;
+  }
+  char tmp[64];
+  sprintf(tmp, "RX %d bytes, RSSI: %d, SNR: %d\n", pkt.len, pkt.rssi, pkt.snr);
+  SerialUSB.print(tmp);
+  notifyBLE(tmp);
+  hexDump(pkt.bytes, pkt.len);
+  pingFrame f;
+  if (decodePing(pkt.bytes, pkt.len, f)) {
+    char text[64];
+    SerialUSB.println(formatPing(f, text));
+    notifyBLE(text);
+  }
+}
+
+void radioArmed(uint8_t result, const char *line, void *ctx) {
+  if (result == AT_OK) {
+    radioState = RADIO_RX;
+    return;
+  }
+  SerialUSB.printf("Radio: RX not armed: %s\n", line);
+  radioState = RADIO_IDLE;
+  radioRetryAt = millis() + RADIO_RETRY_MS;
+}
+
+void radioTxDone(uint8_t result, const char *line, void *ctx) {
+  radioFrame &f = radioQueue[radioHead];
+  uint32_t ms = (frameTimeOnAir(f.len) + 999) / 1000;
+  // Charged even on failure: the E5 may have sent it.
+  dutyBand *band = dutyBandFor(myFreq);
+  if (band) dutyCharge(band, ms);
+  radioHead = (radioHead + 1) % RADIO_QUEUE_LEN;
+  radioCount--;
+  radioState = RADIO_IDLE;
+  if (result != AT_OK) {
+    radioFailed++;
+    SerialUSB.printf("Radio: TX failed: %s\n", line);
+    return;
+  }
+  radioSent++;
+  char duty[48], tmp[64];
+  sprintf(tmp, "Duty %s\n", formatDuty(duty));
+  notifyBLE(tmp);
+  if (radioTxHandler) radioTxHandler(ms);
+}
+
+// Sends the next frame if the budget has room for it, else keeps RX on.
+void radioPoll() {
+  // initLoRaSettings() talks to the E5 directly, which ends RX.
+  if (radioConfigs != loraConfigs) {
+    radioConfigs = loraConfigs;
+    if (radioState == RADIO_RX) radioState = RADIO_IDLE;
+  }
+  if (radioState == RADIO_ARMING || radioState == RADIO_TX) return;
+  if (radioCount > 0) {
+    radioFrame &f = radioQueue[radioHead];
+    uint32_t ms = (frameTimeOnAir(f.len) + 999) / 1000;
+    dutyAdvance();
+    dutyBand *band = dutyBandFor(myFreq);
+    if (band && dutyUsed(band) + ms > dutyBudget(band)) {
+      if (!radioDeferred) SerialUSB.printf("TX deferred: %lu ms on air would exceed %s's budget\n", ms, band->name);
+      radioDeferred = true;
+    } else if (atSendHex("AT+TEST=TXLRPKT,", f.data, f.len, radioTxDone, NULL, ms + AT_TIMEOUT_MS, "+TEST: TX DONE")) {
+      radioDeferred = false;
+      SerialUSB.printf("Send hex, %lu ms on air.\n", ms);
+      hexDump(f.data, f.len);
+      radioState = RADIO_TX;
+      return;
+    }
+  }
+  if (radioState == RADIO_IDLE && (int32_t)(millis() - radioRetryAt) >= 0 && atSend("AT+TEST=RXLRPKT", radioArmed, NULL, AT_TIMEOUT_MS, "+TEST: RXLRPKT"))
+    radioState = RADIO_ARMING;
+}
+
+void radioBegin() {
+  atListen(radioRxBuffer, sizeof(radioRxBuffer), radioPacket);
+  pingTimer = millis();
+}
+
+void pingPoll() {
+  if (millis() - pingTimer < myPingInterval * 1000UL) return;
+  pingTimer = millis();
+  pingFrame f;
+  uint8_t len = buildPing(f, pingCount++);
+  if (!radioSend((uint8_t*)&f, len)) SerialUSB.println("TX queue full, ping dropped.");
+}
+
+void printRadio() {
+  const char *states[] = {"idle", "arming RX", "RX", "TX"};
+  SerialUSB.printf("Radio: %s, %d queued, %lu sent, %lu failed, %lu received, %lu bad RX lines\n", states[radioState], radioCount, radioSent, radioFailed, radioReceived, atRx.errors);
+  printDuty();
+}
+
+// Screen animations, stepped with the rest; set by the UI.
+void (*backgroundDraw)() = NULL;
+
+// Everything that must keep running while a screen waits for a key.
+void backgroundTasks() {
+  gpsPoll();
+  atPoll();
+  pingPoll();
+  radioPoll();
+  pollPrefs();
+  if (backgroundDraw) backgroundDraw();
+}
@@ -8,9 +8,9 @@
 #include <WInterrupts.h>
 
 SoftwareSerial *SoftwareSerial::active_object = 0;
-char SoftwareSerial::_receive_buffer[_SS_MAX_RX_BUFF];
-volatile uint16_t SoftwareSerial::_receive_buffer_tail = 0;
-volatile uint16_t SoftwareSerial::_receive_buffer_head = 0;
+SoftwareSerial *SoftwareSerial::tx_object = 0;
+char SoftwareSerial::_default_receive_buffer[_SS_MAX_RX_BUFF];
+SoftwareSerial *SoftwareSerial::_default_buffer_owner = 0;
 static EExt_Interrupts DigitalPin_To_Interrupt(uint8_t pin) {
 #if (ARDUINO_SAMD_VARIANT_COMPLIANCE >= 10606)
   return g_APinDescription[pin].ulExtInt;
@@ -26,7 +26,14 @@ bool SoftwareSerial::listen() {
     if (active_object)
       active_object->stopListening();
     _buffer_overflow = false;
-    _receive_buffer_head = _receive_buffer_tail = 0;
+    if (_receive_buffer == _default_receive_buffer && _default_buffer_owner != this) {
+      // The shared buffer changes hands: whatever the last owner left
+      // there is gone, as with the original library.
+      if (_default_buffer_owner)
+        _default_buffer_owner->_receive_buffer_head = _default_buffer_owner->_receive_buffer_tail;
+      _default_buffer_owner = this;
+      _receive_buffer_head = _receive_buffer_tail = 0;
+    }
     active_object = this;
     if (_inverse_logic)
       //Start bit high
@@ -34,6 +41,9 @@ bool SoftwareSerial::listen() {
     else
       //Start bit low
       attachInterrupt(_receivePin, handle_interrupt, FALLING);
+    // Below SS_TX_TC, which must not wait out a busy-wait byte, whichever
+    // port is sending.
+    NVIC_SetPriority((IRQn_Type)(EIC_0_IRQn + DigitalPin_To_Interrupt(_receivePin)), 1);
 
     return true;
   }
@@ -43,18 +53,84 @@ bool SoftwareSerial::listen() {
 bool SoftwareSerial::stopListening() {
   if (active_object == this) {
     EIC->INTENCLR.reg = EIC_INTENCLR_EXTINT(1 << DigitalPin_To_Interrupt(_receivePin)) ;
+    if (_rx_engine == SS_RX_TIMER) {
+      SS_RX_TC->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+      _rx_bitcount = 0;
+    }
+    _rx_active = false;
     active_object = NULL;
     return true;
   }
   return false;
 }
 
+void SoftwareSerial::store(uint8_t d) {
+  if (_inverse_logic) d = ~d;
+  // Single producer: only this interrupt moves tail, only the reader
+  // moves head. The byte must be in memory before tail says so.
+  uint16_t tail = _receive_buffer_tail;
+  if ((uint16_t)(tail - _receive_buffer_head) <= _receive_buffer_mask) {
+    _receive_buffer[tail & _receive_buffer_mask] = d; // save new byte
+    __DMB();
+    _receive_buffer_tail = tail + 1;
+    uint16_t occupancy = tail + 1 - _receive_buffer_head;
+    if (occupancy > _stats.maxOccupancy) _stats.maxOccupancy = occupancy;
+    _stats.occupancySum += occupancy;
+    _stats.received++;
+  } else {
+    _buffer_overflow = true;
+    _stats.dropped++;
+  }
+  _rx_bytes++;
+}
+
+// Middle of the stop bit: check it, and note the time for jitter().
+void SoftwareSerial::stopBit(bool high, uint32_t now) {
+  if (high == (bool)_inverse_logic) _stats.framingErrors++;
+  _rx_stop_cycles = now;
+}
+
+// Start edge seen at entry. A back-to-back byte's edge is due half a bit
+// after the last stop bit sample; anything later followed an idle line.
+// Entering earlier than due (this byte's latency below the last one's)
+// counts as 0. The window is checked on the unsigned time since the
+// sample, so an idle gap of any length is never taken for a short one.
+void SoftwareSerial::jitter(uint32_t entry) {
+  uint32_t since = entry - _rx_stop_cycles, due = _rx_bit_cycles / 2;
+  if (since >= due + _rx_bit_cycles) return;
+  uint32_t late = since > due ? since - due : 0;
+  if (late > _stats.maxJitter) _stats.maxJitter = late;
+  uint8_t bin = 0;
+  while (bin < SS_JITTER_BINS - 1 && late >= (SS_JITTER_BIN0 << bin)) bin++;
+  _stats.jitter[bin]++;
+}
+
+void SoftwareSerial::rxStats(SoftwareSerialStats &stats) {
+  noInterrupts();
+  stats = _stats;
+  interrupts();
+}
+
+void SoftwareSerial::resetRxStats() {
+  noInterrupts();
+  memset(&_stats, 0, sizeof(_stats));
+  interrupts();
+}
+
 void SoftwareSerial::recv() {
+  uint32_t t0 = DWT->CYCCNT;
   uint8_t d = 0;
   // If RX line is high, then we don't see any start bit
   // so interrupt is probably not for us
   if (_inverse_logic ? rx_pin_read() : !rx_pin_read()) {
     EIC->INTENCLR.reg = EIC_INTENCLR_EXTINT(1 << DigitalPin_To_Interrupt(_receivePin));
+    jitter(t0);
+    _rx_active = true;
+    if (_rx_engine == SS_RX_TIMER) {
+      recvTimerStart();
+      _rx_cycles += DWT->CYCCNT - t0;
+      return;
+    }
     // Wait approximately 1/2 of a bit width to "center" the sample
     delayMicroseconds(_rx_delay_centering);
     // Read each of the 8 bits
@@ -63,20 +139,113 @@ void SoftwareSerial::recv() {
       d >>= 1;
       if (rx_pin_read()) d |= 0x80;
     }
-    if (_inverse_logic) d = ~d;
-    // if buffer full, set the overflow flag and return
-    uint16_t next = (_receive_buffer_tail + 1) % _SS_MAX_RX_BUFF;
-    if (next != _receive_buffer_head) {
-      // save new data in buffer: tail points to where byte goes
-      _receive_buffer[_receive_buffer_tail] = d; // save new byte
-      _receive_buffer_tail = next;
-    } else {
-      _buffer_overflow = true;
-    }
+    store(d);
     // skip the stop bit
     delayMicroseconds(_rx_delay_stopbit);
+    stopBit(rx_pin_read(), DWT->CYCCNT);
+    _rx_active = false;
     EIC->INTENSET.reg = EIC_INTENSET_EXTINT(1 << DigitalPin_To_Interrupt(_receivePin));
   }
+  _rx_cycles += DWT->CYCCNT - t0;
+}
+
+// SS_RX_TIMER: the TC counts down in MFRQ mode and interrupts each time
+// it wraps to CC0. Loading 1.5 bits first, then 1 bit, lands every sample
+// in the middle of its bit.
+void SoftwareSerial::recvTimerStart() {
+  TcCount16 *tc = &SS_RX_TC->COUNT16;
+  _rx_bitcount = 0;
+  _rx_byte = 0;
+  tc->CC[0].reg = _rx_ticks_first;
+  while (tc->SYNCBUSY.bit.CC0);
+  tc->CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+  while (tc->SYNCBUSY.bit.CTRLB);
+  // Takes effect at the first wrap.
+  tc->CC[0].reg = _rx_ticks_bit;
+}
+
+void SoftwareSerial::recvTimerBit() {
+  uint32_t t0 = DWT->CYCCNT;
+  TcCount16 *tc = &SS_RX_TC->COUNT16;
+  tc->INTFLAG.reg = TC_INTFLAG_OVF;
+  bool high = rx_pin_read();
+  if (_rx_bitcount < 8) {
+    _rx_byte >>= 1;
+    if (high) _rx_byte |= 0x80;
+    _rx_bitcount++;
+  } else {
+    // Middle of the stop bit: done. Forget the edges seen during the
+    // byte, then wait for the next start bit.
+    tc->CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+    _rx_bitcount = 0;
+    stopBit(high, t0);
+    _rx_active = false;
+    store(_rx_byte);
+    uint8_t extint = DigitalPin_To_Interrupt(_receivePin);
+    EIC->INTFLAG.reg = 1 << extint;
+    EIC->INTENSET.reg = EIC_INTENSET_EXTINT(1 << extint);
+  }
+  _rx_cycles += DWT->CYCCNT - t0;
+}
+
+// Buffered transmit: SS_TX_TC interrupts once per bit. txStart() drives
+// the start bit and loads the rest of the frame, txBit() shifts it out.
+// After the stop bit has lasted a bit, the next byte starts at once.
+void SoftwareSerial::txPin(bool high) {
+  if (high != (bool)_inverse_logic) _transmitPortRegister->reg |= _transmitBitMask;
+  else _transmitPortRegister->reg &= ~_transmitBitMask;
+}
+
+void SoftwareSerial::txStart(bool retrigger) {
+  uint16_t head = _transmit_buffer_head;
+  __DMB();
+  uint8_t b = _transmit_buffer[head & _transmit_buffer_mask];
+  __DMB();
+  _transmit_buffer_head = head + 1;
+  txPin(false);
+  _tx_frame = b | 0x100; // 8 data bits, then the stop bit
+  _tx_bitcount = 9;
+  if (retrigger) {
+    TcCount16 *tc = &SS_TX_TC->COUNT16;
+    tc->CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    while (tc->SYNCBUSY.bit.CTRLB);
+  }
+}
+
+void SoftwareSerial::txBit() {
+  TcCount16 *tc = &SS_TX_TC->COUNT16;
+  tc->INTFLAG.reg = TC_INTFLAG_OVF;
+  if (_tx_bitcount) {
+    txPin(_tx_frame & 1);
+    _tx_frame >>= 1;
+    _tx_bitcount--;
+  } else if (_transmit_buffer_head == _transmit_buffer_tail) {
+    tc->CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+    _tx_busy = false;
+  } else if (!(_half_duplex && _rx_active)) {
+    txStart(false);
+  }
+  // else: the line stays idle until the incoming byte's stop bit.
+}
+
+void SoftwareSerial::setupTimer(Tc *timer, uint8_t gclkId, IRQn_Type irq) {
+  TcCount16 *tc = &timer->COUNT16;
+  GCLK->PCHCTRL[gclkId].reg = GCLK_PCHCTRL_GEN_GCLK1 | GCLK_PCHCTRL_CHEN;
+  while (!(GCLK->PCHCTRL[gclkId].reg & GCLK_PCHCTRL_CHEN));
+  tc->CTRLA.reg = TC_CTRLA_SWRST;
+  while (tc->SYNCBUSY.bit.SWRST);
+  tc->CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_PRESCALER_DIV1;
+  tc->WAVE.reg = TC_WAVE_WAVEGEN_MFRQ;
+  tc->CTRLBSET.reg = TC_CTRLBSET_DIR; // count down
+  while (tc->SYNCBUSY.bit.CTRLB);
+  tc->INTENSET.reg = TC_INTENSET_OVF;
+  NVIC_SetPriority(irq, 0);
+  NVIC_EnableIRQ(irq);
+  tc->CTRLA.bit.ENABLE = 1;
+  while (tc->SYNCBUSY.bit.ENABLE);
+  // Enabling starts the count: park it until a start bit comes.
+  tc->CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+  while (tc->SYNCBUSY.bit.CTRLB);
 }
 
 uint32_t SoftwareSerial::rx_pin_read() {
@@ -90,14 +259,63 @@ inline void SoftwareSerial::handle_interrupt() {
   }
 }
 
+/* static */
+inline void SoftwareSerial::handle_timer() {
+  if (active_object) {
+    active_object->recvTimerBit();
+  } else {
+    SS_RX_TC->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+  }
+}
+
+/* static */
+inline void SoftwareSerial::handle_tx_timer() {
+  if (tx_object) {
+    tx_object->txBit();
+  } else {
+    SS_TX_TC->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+  }
+}
+
+void SS_RX_TC_Handler() {
+  SoftwareSerial::handle_timer();
+}
+
+void SS_TX_TC_Handler() {
+  SoftwareSerial::handle_tx_timer();
+}
+
 // Constructor
 SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverse_logic /* = false */) :
+  SoftwareSerial(receivePin, transmitPin, inverse_logic, _default_receive_buffer, _SS_MAX_RX_BUFF) {
+}
+
+SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverse_logic, char *receiveBuffer, uint16_t receiveSize, char *transmitBuffer, uint16_t transmitSize) :
   _rx_delay_centering(0),
   _rx_delay_intrabit(0),
   _rx_delay_stopbit(0),
   _tx_delay(0),
   _buffer_overflow(false),
-  _inverse_logic(inverse_logic) {
+  _inverse_logic(inverse_logic),
+  _rx_engine(SS_RX_ENGINE),
+  _rx_bitcount(0),
+  _rx_active(false),
+  _rx_cycles(0),
+  _rx_bytes(0),
+  _stats(),
+  _rx_stop_cycles(0),
+  _rx_bit_cycles(0),
+  _receive_buffer(receiveBuffer),
+  _receive_buffer_mask(receiveSize - 1),
+  _receive_buffer_tail(0),
+  _receive_buffer_head(0),
+  _transmit_buffer(transmitBuffer),
+  _transmit_buffer_mask(transmitSize - 1),
+  _transmit_buffer_tail(0),
+  _transmit_buffer_head(0),
+  _tx_bitcount(0),
+  _tx_busy(false),
+  _half_duplex(false) {
   _receivePin = receivePin;
   _transmitPin = transmitPin;
 }
@@ -105,6 +323,7 @@ SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inv
 // Destructor
 SoftwareSerial::~SoftwareSerial() {
   end();
+  if (tx_object == this) tx_object = NULL;
 }
 
 void SoftwareSerial::setTX(uint8_t tx) {
@@ -130,11 +349,18 @@ void SoftwareSerial::setRX(uint8_t rx) {
 }
 
 void SoftwareSerial::begin(long speed) {
+  // Finish sending at the old speed first.
+  flush();
+  // A port already listening is re-begun from scratch: setRX() resets
+  // the pin's interrupt routing, the RX timer may be mid-byte, and
+  // listen() only re-attaches a port that isn't listening.
+  stopListening();
   setTX(_transmitPin);
   setRX(_receivePin);
   // Precalculate the various delays
   //Calculate the distance between bit in micro seconds
   uint32_t bit_delay = (float(1) / speed) * 1000000;
+  _rx_bit_cycles = F_CPU / speed;
   _tx_delay = bit_delay;
   // Only setup rx when we have a valid PCINT for this pin
   if (DigitalPin_To_Interrupt(_receivePin) != NOT_AN_INTERRUPT) {
@@ -146,27 +372,139 @@ void SoftwareSerial::begin(long speed) {
     _rx_delay_stopbit = bit_delay;
     delayMicroseconds(_tx_delay);
   }
+  // Ticks per bit for SS_RX_TIMER. The first interval is 1.5 bits, minus
+  // ~2 us for the pin interrupt to get there.
+  uint32_t ticks = (SS_RX_TC_HZ + speed / 2) / speed;
+  if (ticks * 3 / 2 > 0xFFFF) _rx_engine = SS_RX_BUSYWAIT;
+  if (_rx_engine == SS_RX_TIMER) {
+    _rx_ticks_bit = ticks - 1;
+    _rx_ticks_first = ticks * 3 / 2 - 2 * (SS_RX_TC_HZ / 1000000);
+    setupTimer(SS_RX_TC, SS_RX_TC_GCLK_ID, SS_RX_TC_IRQn);
+  }
+  if (_transmit_buffer) {
+    if (ticks > 0x10000) {
+      // Too slow for the timer: send blocking.
+      _transmit_buffer = NULL;
+    } else {
+      _tx_ticks_bit = ticks - 1;
+      // The TX timer may be another port's, mid-byte: resetting it now
+      // would leave that port busy forever. Let it finish, as write()
+      // does, then take the timer over.
+      while (tx_object && tx_object->_tx_busy);
+      tx_object = this;
+      setupTimer(SS_TX_TC, SS_TX_TC_GCLK_ID, SS_TX_TC_IRQn);
+      SS_TX_TC->COUNT16.CC[0].reg = _tx_ticks_bit;
+      while (SS_TX_TC->COUNT16.SYNCBUSY.bit.CC0);
+    }
+  }
+  // DWT cycle counter, for rxCyclesPerByte()
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
   listen();
 }
 
+long SoftwareSerial::autobaud(uint32_t timeout, uint16_t edges) {
+  const long rates[] = {4800, 9600, 19200, 38400, 57600, 115200};
+  // Anything shorter than half a bit at the fastest rate is a glitch.
+  const uint32_t glitch = F_CPU / 115200 / 2;
+  bool listening = isListening();
+  stopListening();
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  // Poll the pin, 10 ms at a time with interrupts off: an interrupt
+  // between an edge and its timestamp would make a pulse look shorter.
+  // A missed edge only makes one look longer, and the shortest is a
+  // single bit. millis() stalls meanwhile, so chunks keep the time.
+  uint32_t shortest = 0xFFFFFFFF;
+  for (uint32_t chunks = (timeout + 9) / 10; edges && chunks; chunks--) {
+    noInterrupts();
+    uint32_t t0 = DWT->CYCCNT, edge = t0;
+    uint32_t level = rx_pin_read();
+    bool first = true;
+    while (edges && DWT->CYCCNT - t0 < F_CPU / 100) {
+      uint32_t pin = rx_pin_read();
+      if (pin == level) continue;
+      uint32_t now = DWT->CYCCNT;
+      if (!first && now - edge > glitch && now - edge < shortest) shortest = now - edge;
+      first = false;
+      edge = now;
+      level = pin;
+      edges--;
+    }
+    interrupts();
+  }
+  long rate = 0;
+  if (shortest != 0xFFFFFFFF) {
+    long measured = F_CPU / shortest;
+    // Nearest standard rate, if within 10%.
+    for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+      long delta = measured - rates[i];
+      if (delta < 0) delta = -delta;
+      if (delta * 10 < rates[i]) rate = rates[i];
+    }
+  }
+  if (rate) begin(rate);
+  else if (listening) listen();
+  return rate;
+}
+
 void SoftwareSerial::end() {
   stopListening();
 }
 
 int SoftwareSerial::read() {
-  if (!isListening()) return -1;
+  uint16_t head = _receive_buffer_head;
   // Empty buffer?
-  if (_receive_buffer_head == _receive_buffer_tail) return -1;
+  if (head == _receive_buffer_tail) return -1;
+  __DMB();
   // Read from "head"
-  uint8_t d = _receive_buffer[_receive_buffer_head]; // grab next byte
-  _receive_buffer_head = (_receive_buffer_head + 1) % _SS_MAX_RX_BUFF;
+  uint8_t d = _receive_buffer[head & _receive_buffer_mask]; // grab next byte
+  __DMB();
+  _receive_buffer_head = head + 1;
   return d;
 }
 
 int SoftwareSerial::available() {
-  if (!isListening())
-    return 0;
-  return (_receive_buffer_tail + _SS_MAX_RX_BUFF - _receive_buffer_head) % _SS_MAX_RX_BUFF;
+  return (uint16_t)(_receive_buffer_tail - _receive_buffer_head);
+}
+
+size_t SoftwareSerial::readBytes(uint8_t *buffer, size_t n) {
+  uint16_t head = _receive_buffer_head;
+  uint16_t count = _receive_buffer_tail - head;
+  __DMB();
+  if (count > n) count = n;
+  // At most two contiguous spans: up to the end of the ring, then from 0.
+  uint16_t start = head & _receive_buffer_mask;
+  uint16_t first = _receive_buffer_mask + 1 - start;
+  if (first > count) first = count;
+  memcpy(buffer, _receive_buffer + start, first);
+  memcpy(buffer + first, _receive_buffer, count - first);
+  __DMB();
+  _receive_buffer_head = head + count;
+  return count;
+}
+
+size_t SoftwareSerial::readUntil(uint8_t *buffer, size_t n, char terminator) {
+  uint16_t head = _receive_buffer_head;
+  uint16_t count = _receive_buffer_tail - head;
+  __DMB();
+  if (count > n) count = n;
+  uint16_t start = head & _receive_buffer_mask;
+  uint16_t first = _receive_buffer_mask + 1 - start;
+  if (first > count) first = count;
+  const char *found = (const char*)memchr(_receive_buffer + start, terminator, first);
+  if (found) {
+    count = found - (_receive_buffer + start) + 1;
+  } else {
+    found = (const char*)memchr(_receive_buffer, terminator, count - first);
+    if (found) count = first + (found - _receive_buffer) + 1;
+  }
+  if (first > count) first = count;
+  memcpy(buffer, _receive_buffer + start, first);
+  memcpy(buffer + first, _receive_buffer, count - first);
+  __DMB();
+  _receive_buffer_head = head + count;
+  return count;
 }
 
 size_t SoftwareSerial::write(uint8_t b) {
@@ -174,6 +512,38 @@ size_t SoftwareSerial::write(uint8_t b) {
     setWriteError();
     return 0;
   }
+  if (!_transmit_buffer) return writeBlocking(b);
+  // The TX timer serves one port at a time.
+  if (tx_object != this) {
+    while (tx_object && tx_object->_tx_busy);
+    tx_object = this;
+    SS_TX_TC->COUNT16.CC[0].reg = _tx_ticks_bit;
+    while (SS_TX_TC->COUNT16.SYNCBUSY.bit.CC0);
+  }
+  uint16_t tail = _transmit_buffer_tail;
+  while ((uint16_t)(tail - _transmit_buffer_head) > _transmit_buffer_mask); // full: wait for the timer
+  _transmit_buffer[tail & _transmit_buffer_mask] = b;
+  __DMB();
+  _transmit_buffer_tail = tail + 1;
+  // If the timer stopped before seeing this byte, restart it. Once
+  // stopped, it can't run again until txStart(). The start bit and the
+  // retrigger go together: a pin interrupt in between (~1 ms with the
+  // busy-wait engine) would stretch the start bit.
+  if (!_tx_busy) {
+    noInterrupts();
+    _tx_busy = true;
+    txStart(true);
+    interrupts();
+  }
+  return 1;
+}
+
+int SoftwareSerial::availableForWrite() {
+  if (!_transmit_buffer) return 0;
+  return _transmit_buffer_mask + 1 - (uint16_t)(_transmit_buffer_tail - _transmit_buffer_head);
+}
+
+size_t SoftwareSerial::writeBlocking(uint8_t b) {
   // By declaring these as local variables, the compiler will put them
   // in registers _before_ disabling interrupts and entering the
   // critical timing sections below, which makes it a lot easier to
@@ -207,16 +577,15 @@ size_t SoftwareSerial::write(uint8_t b) {
 }
 
 void SoftwareSerial::flush() {
-  if (!isListening()) return;
-  EIC->INTENCLR.reg = EIC_INTENCLR_EXTINT(1 << DigitalPin_To_Interrupt(_receivePin)) ;
-  _receive_buffer_head = _receive_buffer_tail = 0;
-  EIC->INTENSET.reg = EIC_INTENSET_EXTINT(1 << DigitalPin_To_Interrupt(_receivePin)) ;
+  // Blocking writes are done when they return.
+  while (_tx_busy);
 }
 
 int SoftwareSerial::peek() {
-  if (!isListening()) return -1;
+  uint16_t head = _receive_buffer_head;
   // Empty buffer?
-  if (_receive_buffer_head == _receive_buffer_tail) return -1;
+  if (head == _receive_buffer_tail) return -1;
+  __DMB();
   // Read from "head"
-  return _receive_buffer[_receive_buffer_head];
+  return (uint8_t)_receive_buffer[head & _receive_buffer_mask];
 }
@@ -17,11 +17,64 @@
 #define portInputReg(port) (&(port->IN))
 #define portModeReg(port) (&(port->DIR))
 
-#define _SS_MAX_RX_BUFF 1200 // RX buffer size
+// RX buffer size for the plain SoftwareSerial, whose instances share one
+// static buffer. SoftwareSerialT<RxSize> gives a port a buffer of its own.
+// Sizes are powers of 2, so ring indices wrap with a mask: head and tail
+// run freely and are only masked when indexing.
+#define _SS_MAX_RX_BUFF 1024
+
+// RX engines. SS_RX_BUSYWAIT samples the whole byte inside the pin
+// interrupt (~1 ms of CPU per byte at 9600 bps). SS_RX_TIMER only
+// catches the start bit there, then samples each bit from a TC
+// interrupt, leaving the CPU free between bits.
+#define SS_RX_BUSYWAIT 0
+#define SS_RX_TIMER 1
+#ifndef SS_RX_ENGINE
+#define SS_RX_ENGINE SS_RX_TIMER
+#endif
+// Timer owned by SS_RX_TIMER, clocked from GCLK1 (48 MHz).
+#ifndef SS_RX_TC
+#define SS_RX_TC TC3
+#define SS_RX_TC_IRQn TC3_IRQn
+#define SS_RX_TC_GCLK_ID TC3_GCLK_ID
+#define SS_RX_TC_Handler TC3_Handler
+#endif
+// Timer owned by buffered transmit, also on GCLK1. It outranks the pin
+// interrupt, and write() starts a byte with interrupts off, so the
+// busy-wait engine can't stall a byte going out.
+#ifndef SS_TX_TC
+#define SS_TX_TC TC4
+#define SS_TX_TC_IRQn TC4_IRQn
+#define SS_TX_TC_GCLK_ID TC4_GCLK_ID
+#define SS_TX_TC_Handler TC4_Handler
+#endif
+#define SS_RX_TC_HZ 48000000UL
 #ifndef GCC_VERSION
 #define GCC_VERSION (__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__)
 #endif
 
+static_assert((_SS_MAX_RX_BUFF & (_SS_MAX_RX_BUFF - 1)) == 0, "_SS_MAX_RX_BUFF must be a power of 2");
+
+// Receive counters, see rxStats(). Jitter is measured on bytes that
+// follow the previous one back to back, whose start edge is due half a
+// bit after the previous stop bit sample: it is how much later than that
+// the pin interrupt ran, in CPU cycles. The sample was itself taken late,
+// so this is the change in entry latency from one byte to the next plus
+// an offset that depends on the engine, not the latency itself. Other
+// bytes aren't binned. Bin i counts values below SS_JITTER_BIN0 << i,
+// the last bin everything above.
+#define SS_JITTER_BINS 8
+#define SS_JITTER_BIN0 64
+struct SoftwareSerialStats {
+  uint32_t received; // bytes stored
+  uint32_t dropped; // bytes lost to a full buffer
+  uint32_t framingErrors; // stop bit not at the idle level
+  uint16_t maxOccupancy; // bytes buffered, after each store
+  uint64_t occupancySum; // mean occupancy = occupancySum / received
+  uint32_t jitter[SS_JITTER_BINS];
+  uint32_t maxJitter;
+};
+
 class SoftwareSerial : public Stream {
   private:
     // per object data
@@ -38,19 +91,62 @@ class SoftwareSerial : public Stream {
     uint16_t _tx_delay;
     uint16_t _buffer_overflow: 1;
     uint16_t _inverse_logic: 1;
+    uint8_t _rx_engine;
+    // SS_RX_TIMER state, in TC ticks
+    uint16_t _rx_ticks_first;
+    uint16_t _rx_ticks_bit;
+    uint8_t _rx_bitcount;
+    uint8_t _rx_byte;
+    volatile bool _rx_active; // between a start bit and its stop bit
+    // CPU cycles spent in RX interrupts, and bytes they produced
+    volatile uint32_t _rx_cycles;
+    volatile uint32_t _rx_bytes;
+    // Receive counters, and the DWT time of the last stop bit sample
+    SoftwareSerialStats _stats;
+    uint32_t _rx_stop_cycles;
+    uint32_t _rx_bit_cycles;
+    // RX ring, owned by the instance or the shared default
+    char *_receive_buffer;
+    uint16_t _receive_buffer_mask;
+    volatile uint16_t _receive_buffer_tail;
+    volatile uint16_t _receive_buffer_head;
+    // TX ring, drained by the TX timer. No buffer means write() blocks.
+    char *_transmit_buffer;
+    uint16_t _transmit_buffer_mask;
+    volatile uint16_t _transmit_buffer_tail;
+    volatile uint16_t _transmit_buffer_head;
+    uint16_t _tx_ticks_bit;
+    uint16_t _tx_frame; // bits left to send, LSB first
+    uint8_t _tx_bitcount;
+    volatile bool _tx_busy;
+    bool _half_duplex;
     // static data
-    static char _receive_buffer[_SS_MAX_RX_BUFF];
-    static volatile uint16_t _receive_buffer_tail;
-    static volatile uint16_t _receive_buffer_head;
+    static char _default_receive_buffer[_SS_MAX_RX_BUFF];
+    static SoftwareSerial *_default_buffer_owner;
     static SoftwareSerial *active_object;
+    static SoftwareSerial *tx_object;
     // private methods
     void recv() __attribute__((__always_inline__));
+    void recvTimerStart();
+    void recvTimerBit();
+    void store(uint8_t d);
+    void stopBit(bool high, uint32_t now);
+    void jitter(uint32_t entry);
+    void setupTimer(Tc *timer, uint8_t gclkId, IRQn_Type irq);
+    size_t writeBlocking(uint8_t b);
+    void txStart(bool retrigger);
+    void txBit();
+    void txPin(bool high);
     uint32_t rx_pin_read();
     void tx_pin_write(uint8_t pin_state) __attribute__((__always_inline__));
     void setTX(uint8_t transmitPin);
     void setRX(uint8_t receivePin);
     void setRxIntMsk(bool enable) __attribute__((__always_inline__));
+    // Host tests reach the ring through this, see test/probe.h.
+    friend struct SoftwareSerialProbe;
 
+  protected:
+    SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverse_logic, char *receiveBuffer, uint16_t receiveSize, char *transmitBuffer = 0, uint16_t transmitSize = 0);
 
   public:
     // public methods
@@ -63,15 +159,61 @@ class SoftwareSerial : public Stream {
       return this == active_object;
     }
     bool stopListening();
+    // Times RX edges for up to timeout ms, snaps the shortest pulse to a
+    // standard rate and begin()s at it. Returns the rate, or 0 if the
+    // line stayed quiet or looked like no standard rate.
+    long autobaud(uint32_t timeout = 1500, uint16_t edges = 200);
     bool overflow() {
       bool ret = _buffer_overflow;
       if (ret) _buffer_overflow = false;
       return ret;
     }
     int peek();
+    // Call before begin(), which starts listening again. SS_RX_TIMER
+    // needs at least 1200 bps.
+    void setRxEngine(uint8_t engine) {
+      // Stops the old engine, timer included, before it's forgotten.
+      stopListening();
+      _rx_engine = engine;
+    }
+    uint8_t rxEngine() {
+      return _rx_engine;
+    }
+    // Mean CPU cycles spent in RX interrupts per received byte.
+    uint32_t rxCyclesPerByte() {
+      return _rx_bytes ? _rx_cycles / _rx_bytes : 0;
+    }
+    void resetRxCycles() {
+      _rx_cycles = _rx_bytes = 0;
+    }
+    // Rate actually sent, in bps: begin() rounds the bit time to whole
+    // TX timer ticks (buffered) or microseconds (blocking, which loop
+    // overhead then stretches further).
+    long txBaud() {
+      if (_transmit_buffer) return (SS_RX_TC_HZ + (_tx_ticks_bit + 1) / 2) / (_tx_ticks_bit + 1);
+      return _tx_delay ? 1000000L / _tx_delay : 0;
+    }
+    // Half duplex: a byte waiting to go out holds back while one is
+    // coming in, so the incoming byte isn't lost to a shared line.
+    void setHalfDuplex(bool on) {
+      _half_duplex = on;
+    }
+    // Copies the receive counters with interrupts held off.
+    void rxStats(SoftwareSerialStats &stats);
+    void resetRxStats();
+    // With a TX buffer, write() queues the byte and returns, only waiting
+    // when the buffer is full; flush() waits until everything is sent.
     virtual size_t write(uint8_t byte);
+    virtual int availableForWrite();
     virtual int read();
     virtual int available();
+    // Non-blocking bulk reads: copy what is already buffered, up to n
+    // bytes, and return the count. readUntil() stops after terminator.
+    size_t readBytes(uint8_t *buffer, size_t n);
+    size_t readBytes(char *buffer, size_t n) {
+      return readBytes((uint8_t*)buffer, n);
+    }
+    size_t readUntil(uint8_t *buffer, size_t n, char terminator);
     virtual void flush();
     operator bool() {
       return true;
@@ -80,6 +222,25 @@ class SoftwareSerial : public Stream {
     using Print::write;
     // public only for easy access by interrupt handlers
     static inline void handle_interrupt() __attribute__((__always_inline__));
+    static inline void handle_timer() __attribute__((__always_inline__));
+    static inline void handle_tx_timer() __attribute__((__always_inline__));
+};
+
+// A port with its own buffers, sized for its traffic. Data buffered by a
+// port that stops listening stays there until read. TxSize > 0 sends
+// from SS_TX_TC, one buffered port at a time; 0 keeps write() blocking.
+template <uint16_t RxSize, uint16_t TxSize = 0>
+class SoftwareSerialT : public SoftwareSerial {
+    static_assert(RxSize > 0 && (RxSize & (RxSize - 1)) == 0, "RxSize must be a power of 2");
+    static_assert((TxSize & (TxSize - 1)) == 0, "TxSize must be 0 or a power of 2");
+  private:
+    char _receive_storage[RxSize];
+    char _transmit_storage[TxSize ? TxSize : 1];
+
+  public:
+    SoftwareSerialT(uint8_t receivePin, uint8_t transmitPin, bool inverse_logic = false) :
+      SoftwareSerial(receivePin, transmitPin, inverse_logic, _receive_storage, RxSize, TxSize ? _transmit_storage : 0, TxSize) {
+    }
 };
 
 // Arduino 0012 workaround
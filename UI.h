@@ -68,6 +68,7 @@ void handleLoRaSettings();
 void handleReturnToMain(uint8_t);
 void handleMain1();
 void handleMain2();
+void handleMain3();
 void handleSF();
 void handleBW();
 void handleTx();
@@ -92,9 +93,8 @@ float deg2rad = 0.0174533;
 
 myScreen mainScreen;
 myScreen currentScreen;
-myScreen screenLoRa, screen1, screen2, screenSF, screenBW, screenFreq, screenFreqDecimal, screenTx, screenLumi;
+myScreen screenLoRa, screen1, screen2, screenSF, screenBW, screenFreq, screenFreqDecimal, screenTx, screenLumi, screenGPS, screenSerial;
 
-uint8_t luminosity = 128;
 void drawLuminosity() {
   uint16_t ix, jx = 360 * luminosity / 255, cx = 10, cy = 10, r = 4;
   lcd.setColor(TFT_BLACK);
@@ -116,20 +116,58 @@ void drawLuminosity() {
   }
 }
 
-void drawLoRa(uint8_t px = 18, uint8_t py = 240 - 27, uint8_t w = 16, int color = TFT_CYAN) {
-  uint8_t x = w - 12, i;
-  delay(100);
-  for (i = 0; i < 3; i++) {
-    lcd.drawArc(px, py, x, x, 45, 135, color);
-    lcd.drawArc(px, py, x, x, 225, 315, color);
-    x += 1;
-    lcd.drawArc(px, py, x, x, 45, 135, color);
-    lcd.drawArc(px, py, x, x, 225, 315, color);
-    delay(100);
-    x += 3;
+bool txArea = false;
+
+// The LoRa logo, for TX and RX activity. It is an animation stepped by
+// pollLoRaLogos() from backgroundTasks(): an arc pair every 100 ms, the
+// centre dot, then the logo is wiped hold ms later. Nothing waits on it.
+struct loraLogo {
+  uint8_t px, py, w;
+  int color;
+  uint16_t hold; // ms the finished logo stays up
+  int16_t wipeX, wipeY, wipeW, wipeH;
+  bool active;
+  uint8_t step;
+  uint32_t at; // millis() of the last step
+};
+loraLogo txLogo = {18, 240 - 27, 16, TFT_CYAN, 100, 0, 240 - 40, 36, 40, false, 0, 0};
+loraLogo rxLogo = {18, 18, 16, TFT_GREEN, 500, 0, 0, 32, 32, false, 0, 0};
+
+void startLoRaLogo(loraLogo &logo) {
+  logo.active = true;
+  logo.step = 0;
+  logo.at = millis();
+}
+
+void pollLoRaLogo(loraLogo &logo) {
+  if (!logo.active || millis() - logo.at < (logo.step < 4 ? 100 : logo.hold)) return;
+  logo.at = millis();
+  if (logo.step < 3) {
+    uint8_t x = logo.w - 12 + 4 * logo.step;
+    for (uint8_t i = 0; i < 2; i++, x++) {
+      lcd.drawArc(logo.px, logo.py, x, x, 45, 135, logo.color);
+      lcd.drawArc(logo.px, logo.py, x, x, 225, 315, logo.color);
+    }
+  } else if (logo.step == 3) {
+    lcd.setColor(TFT_BLACK);
+    lcd.fillCircle(logo.px, logo.py, 2);
+  } else {
+    lcd.setColor(TFT_WHITE);
+    lcd.fillRect(logo.wipeX, logo.wipeY, logo.wipeW, logo.wipeH);
+    logo.active = false;
   }
-  lcd.setColor(TFT_BLACK);
-  lcd.fillCircle(px, py, 2);
+  logo.step++;
+}
+
+void pollLoRaLogos() {
+  pollLoRaLogo(txLogo);
+  pollLoRaLogo(rxLogo);
+}
+
+void showTx(uint32_t ms) {
+  if (!txArea) return;
+  startLoRaLogo(txLogo); // the regular LoRa logo in cyan
+  drawDuty();
 }
 
 void setMenuLabels(myScreen thisScreen, vector<string>choices) {
@@ -258,11 +296,22 @@ void initMainScreen() {
   }
 
   LGFX_Button btn2;
-  btn2.initButton(&lcd, px, py, bWidth, bHeight, TFT_BLACK, TFT_LIGHTGREY, TFT_BROWN, "Nothing!");
+  btn2.initButton(&lcd, px, py, bWidth, bHeight, TFT_BLACK, TFT_WHITE, TFT_RED, "GPS");
   btn2.press(false);
   myButton b2 = {handleMain2, btn2, FSS12};
   mainScreen.buttons[2] = b2;
-  mainScreen.buttonCount = 3;
+  py += bHeight + 6;
+  if (py + bHeight > lcd.height()) {
+    py = 60;
+    px += (bWidth + 12);
+  }
+
+  LGFX_Button btn3;
+  btn3.initButton(&lcd, px, py, bWidth, bHeight, TFT_BLACK, TFT_WHITE, TFT_RED, "Serial");
+  btn3.press(false);
+  myButton b3 = {handleMain3, btn3, FSS12};
+  mainScreen.buttons[3] = b3;
+  mainScreen.buttonCount = 4;
   py += bHeight + 6;
   if (py + bHeight > lcd.height()) {
     py = 60;
@@ -344,6 +393,36 @@ void initScreen1() {
   screen1.bgColor = TFT_WHITE;
 }
 
+void initScreenGPS() {
+  // Create the labels
+  myLabel headerLabel = {
+    "Satellites", TXT_CENTERED, TXT_TOP, TFT_BLACK, FSS18
+  };
+  screenGPS.labels[0] = headerLabel;
+  myLabel footerLabel = {
+    "Press a key to return", TXT_CENTERED, TXT_BOTTOM, TFT_BLACK, FSS9
+  };
+  screenGPS.labels[1] = footerLabel;
+  screenGPS.labelCount = 2;
+  screenGPS.buttonCount = 0;
+  screenGPS.bgColor = TFT_WHITE;
+}
+
+void initScreenSerial() {
+  // Create the labels
+  myLabel headerLabel = {
+    "GPS Serial", TXT_CENTERED, TXT_TOP, TFT_BLACK, FSS18
+  };
+  screenSerial.labels[0] = headerLabel;
+  myLabel footerLabel = {
+    "Press a key to return", TXT_CENTERED, TXT_BOTTOM, TFT_BLACK, FSS9
+  };
+  screenSerial.labels[1] = footerLabel;
+  screenSerial.labelCount = 2;
+  screenSerial.buttonCount = 0;
+  screenSerial.bgColor = TFT_WHITE;
+}
+
 void initScreenSF() {
   //  SerialUSB.println("initScreenSF");
   // Create the labels
@@ -483,6 +562,10 @@ void renderScreen(myScreen screen) {
   }
   // SerialUSB.println("Screen rendered!");
   currentScreen = screen;
+  // The screen was cleared: a logo half drawn on the last one is dropped.
+  txLogo.active = rxLogo.active = false;
+  // The main and LoRa screens leave the bottom left free for TX activity.
+  txArea = screen.buttons[0].ptr == mainScreen.buttons[0].ptr || screen.buttons[0].ptr == screenLoRa.buttons[0].ptr;
   // SerialUSB.printf("selectedIndex = %d\n", currentScreen.selectedIndex);
   drawLuminosity();
 }
@@ -792,9 +875,8 @@ void initScreenTx() {
 
 void handleReturnToMain(uint8_t ix) {
   mainScreen.selectedIndex = ix;
-  mainScreen.buttons[0].button.press(false);
-  mainScreen.buttons[1].button.press(false);
-  mainScreen.buttons[2].button.press(false);
+  for (uint8_t i = 0; i < mainScreen.buttonCount; i++)
+    mainScreen.buttons[i].button.press(false);
   mainScreen.buttons[ix].button.press(true);
   renderScreen(mainScreen);
 }
@@ -802,16 +884,181 @@ void handleReturnToMain(uint8_t ix) {
 void handleLoRaSettings() {
   // SerialUSB.println("handleLoRaSettings");
   mainScreen.selectedIndex = 0;
+  for (uint8_t i = 1; i < mainScreen.buttonCount; i++)
+    mainScreen.buttons[i].button.press(false);
   mainScreen.buttons[0].button.press(true);
-  mainScreen.buttons[1].button.press(false);
-  mainScreen.buttons[2].button.press(false);
   screenLoRa.buttons[0].button.press(true);
   renderScreen(screenLoRa);
   currentScreen = screenLoRa;
 }
 
+// Sky plot on the left, one SNR bar per satellite on the right.
+#define SKY_CX 72
+#define SKY_CY 124
+#define SKY_R 62
+#define SKY_BARS 12
+#define BAR_X0 150
+#define BAR_PITCH 14
+#define BAR_W 10
+#define BAR_BOTTOM 190
+#define BAR_MAX_H 140 // 50 dB-Hz full scale
+uint8_t drawnPrn[SKY_BARS], drawnSnr[SKY_BARS];
+uint32_t drawnSky;
+
+int snrColor(uint8_t snr) {
+  if (snr == 0) return TFT_LIGHTGREY;
+  if (snr < 20) return TFT_RED;
+  if (snr < 30) return TFT_ORANGE;
+  return TFT_DARKGREEN;
+}
+
+void drawSkyPlot(const gpsSkyView &view) {
+  lcd.fillCircle(SKY_CX, SKY_CY, SKY_R + 4, TFT_WHITE);
+  lcd.setColor(TFT_DARKGREY);
+  lcd.drawCircle(SKY_CX, SKY_CY, SKY_R);
+  lcd.drawCircle(SKY_CX, SKY_CY, SKY_R * 2 / 3);
+  lcd.drawCircle(SKY_CX, SKY_CY, SKY_R / 3);
+  lcd.drawLine(SKY_CX - SKY_R, SKY_CY, SKY_CX + SKY_R, SKY_CY);
+  lcd.drawLine(SKY_CX, SKY_CY - SKY_R, SKY_CX, SKY_CY + SKY_R);
+  for (uint8_t i = 0; i < view.count; i++) {
+    const gpsSatellite &sat = view.sats[i];
+    if (sat.elevation < 0) continue;
+    float r = SKY_R * (90 - sat.elevation) / 90.0;
+    int16_t x = SKY_CX + sin(deg2rad * sat.azimuth) * r;
+    int16_t y = SKY_CY - cos(deg2rad * sat.azimuth) * r;
+    lcd.fillCircle(x, y, 3, snrColor(sat.snr));
+  }
+}
+
+void drawSnrBar(uint8_t i, const gpsSatellite *sat) {
+  uint16_t x = BAR_X0 + i * BAR_PITCH;
+  lcd.fillRect(x, BAR_BOTTOM - BAR_MAX_H, BAR_W + 2, BAR_MAX_H + 10, TFT_WHITE);
+  if (sat == NULL) return;
+  uint16_t h = (sat->snr > 50 ? 50 : sat->snr) * BAR_MAX_H / 50;
+  if (h == 0) lcd.drawRect(x, BAR_BOTTOM - 2, BAR_W, 2, TFT_LIGHTGREY);
+  else lcd.fillRect(x, BAR_BOTTOM - h, BAR_W, h, snrColor(sat->snr));
+  char tmp[4];
+  sprintf(tmp, "%d", sat->prn);
+  lcd.setTextColor(TFT_BLACK);
+  lcd.drawString(tmp, x, BAR_BOTTOM + 3, TT1);
+}
+
+// Only touches what changed: a bar is redrawn when its satellite or SNR
+// did, the plot only when a satellite moved, appeared, left or changed
+// tracking state.
+void drawSkyView(const gpsSkyView &view) {
+  uint32_t sky = view.count;
+  for (uint8_t i = 0; i < view.count; i++) {
+    const gpsSatellite &sat = view.sats[i];
+    sky = sky * 31 + ((uint32_t)sat.prn << 18) + ((uint32_t)(uint8_t)sat.elevation << 9) + sat.azimuth + (sat.snr == 0 ? 0 : 0x80000000);
+  }
+  if (sky != drawnSky) {
+    drawSkyPlot(view);
+    drawnSky = sky;
+  }
+  for (uint8_t i = 0; i < SKY_BARS; i++) {
+    const gpsSatellite *sat = i < view.count ? &view.sats[i] : NULL;
+    uint8_t prn = sat ? sat->prn : 0, snr = sat ? sat->snr : 0;
+    if (prn == drawnPrn[i] && snr == drawnSnr[i]) continue;
+    drawSnrBar(i, sat);
+    drawnPrn[i] = prn;
+    drawnSnr[i] = snr;
+  }
+}
+
 void handleMain2() {
   // SerialUSB.println("Button 2");
+  GpsFix fix;
+  char tmp[128];
+  getGpsFix(fix);
+  formatGpsFix(fix, tmp);
+  SerialUSB.println(tmp);
+  notifyBLE(tmp);
+  printNMEAStats();
+  renderScreen(screenGPS);
+  // Force a full first draw.
+  memset(drawnPrn, 0xFF, SKY_BARS);
+  drawnSky = 0xFFFFFFFF;
+  uint32_t lastSeq = 0xFFFFFFFF;
+  while (1) {
+    if (digitalRead(WIO_KEY_A) == LOW || digitalRead(WIO_KEY_B) == LOW || digitalRead(WIO_KEY_C) == LOW) {
+      while (digitalRead(WIO_KEY_A) == LOW || digitalRead(WIO_KEY_B) == LOW || digitalRead(WIO_KEY_C) == LOW) backgroundTasks(); // debounce
+      handleReturnToMain(2);
+      return;
+    }
+    backgroundTasks();
+    const gpsSkyView &view = getSkyView();
+    if (view.seq != lastSeq) {
+      drawSkyView(view);
+      lastSeq = view.seq;
+    }
+  }
+}
+
+// GPS port counters on top, entry jitter histogram below.
+#define STAT_X 8
+#define STAT_Y 40
+#define STAT_LINE 18
+#define HIST_X0 20
+#define HIST_PITCH 36
+#define HIST_W 24
+#define HIST_BOTTOM 196
+#define HIST_MAX_H 50
+
+void drawStatLine(uint8_t line, const char *text) {
+  uint16_t y = STAT_Y + line * STAT_LINE;
+  lcd.fillRect(0, y, lcd.width(), STAT_LINE, TFT_WHITE);
+  lcd.setTextColor(TFT_BLACK);
+  lcd.drawString(text, STAT_X, y, FM9);
+}
+
+void drawRxStats(const SoftwareSerialStats &st) {
+  char tmp[40];
+  sprintf(tmp, "Received %lu", st.received);
+  drawStatLine(0, tmp);
+  sprintf(tmp, "Dropped  %lu", st.dropped);
+  drawStatLine(1, tmp);
+  sprintf(tmp, "Framing  %lu", st.framingErrors);
+  drawStatLine(2, tmp);
+  sprintf(tmp, "Buffer   max %u, mean %lu", st.maxOccupancy, st.received ? (uint32_t)(st.occupancySum / st.received) : 0);
+  drawStatLine(3, tmp);
+  sprintf(tmp, "Jitter  max %lu cycles", st.maxJitter);
+  drawStatLine(4, tmp);
+  uint32_t most = 1;
+  for (uint8_t i = 0; i < SS_JITTER_BINS; i++)
+    if (st.jitter[i] > most) most = st.jitter[i];
+  for (uint8_t i = 0; i < SS_JITTER_BINS; i++) {
+    uint16_t x = HIST_X0 + i * HIST_PITCH;
+    uint16_t h = (uint64_t)st.jitter[i] * HIST_MAX_H / most;
+    lcd.fillRect(x, HIST_BOTTOM - HIST_MAX_H, HIST_W, HIST_MAX_H - h, TFT_WHITE);
+    lcd.fillRect(x, HIST_BOTTOM - h, HIST_W, h, TFT_DARKGREEN);
+    if (h == 0) lcd.drawRect(x, HIST_BOTTOM - 2, HIST_W, 2, TFT_LIGHTGREY);
+    if (i < SS_JITTER_BINS - 1) sprintf(tmp, "<%lu", (uint32_t)SS_JITTER_BIN0 << i);
+    else sprintf(tmp, ">=%lu", (uint32_t)SS_JITTER_BIN0 << (i - 1));
+    lcd.drawString(tmp, x, HIST_BOTTOM + 3, TT1);
+  }
+}
+
+void handleMain3() {
+  printRxStats();
+  renderScreen(screenSerial);
+  SoftwareSerialStats st;
+  uint32_t lastDraw = 0, lastCount = 0xFFFFFFFF;
+  while (1) {
+    if (digitalRead(WIO_KEY_A) == LOW || digitalRead(WIO_KEY_B) == LOW || digitalRead(WIO_KEY_C) == LOW) {
+      while (digitalRead(WIO_KEY_A) == LOW || digitalRead(WIO_KEY_B) == LOW || digitalRead(WIO_KEY_C) == LOW) backgroundTasks(); // debounce
+      handleReturnToMain(3);
+      return;
+    }
+    backgroundTasks();
+    if (millis() - lastDraw < 500) continue;
+    lastDraw = millis();
+    gps.rxStats(st);
+    // Counting the bytes in and lost is enough to see a change.
+    if (st.received + st.dropped == lastCount) continue;
+    drawRxStats(st);
+    lastCount = st.received + st.dropped;
+  }
 }
 
 void handleRollover(myScreen thisScreen, vector<string>choices) {
@@ -820,99 +1067,88 @@ void handleRollover(myScreen thisScreen, vector<string>choices) {
   setMenuLabels(thisScreen, choices);
   while (true) {
     if (digitalRead(WIO_5S_UP) == LOW) {
-      while (digitalRead(WIO_5S_UP) == LOW) ; // debounce
+      while (digitalRead(WIO_5S_UP) == LOW) backgroundTasks(); // debounce
       // SerialUSB.println("UP");
       thisScreen.buttons[0].ptr();
     } else if (digitalRead(WIO_5S_DOWN) == LOW) {
-      while (digitalRead(WIO_5S_DOWN) == LOW) ; // debounce
+      while (digitalRead(WIO_5S_DOWN) == LOW) backgroundTasks(); // debounce
       // SerialUSB.println("DOWN");
       thisScreen.buttons[2].ptr();
       SerialUSB.println("Back from DOWN");
     } else if (digitalRead(WIO_5S_PRESS) == LOW) {
-      while (digitalRead(WIO_5S_PRESS) == LOW) ; // debounce
+      while (digitalRead(WIO_5S_PRESS) == LOW) backgroundTasks(); // debounce
       // SerialUSB.println("SELECT");
       thisScreen.buttons[1].ptr();
       return;
     }
+    backgroundTasks();
   }
 }
 
+void listenPacket(const e5Packet &pkt) {
+  SerialUSB.println("Incoming!");
+  startLoRaLogo(rxLogo); // the regular LoRa logo in green
+  lcd.setColor(TFT_WHITE);
+  lcd.fillRect(0, 50, 319, 220);
+  char tmp[128];
+  sprintf(tmp, "Length: %d bytes, RSSI: %d, SNR: %d\n", pkt.len, pkt.rssi, pkt.snr);
+  SerialUSB.print(tmp);
+  notifyBLE(tmp);
+  lcd.drawString(tmp, 4, 50, FSS9);
+  hexDump(pkt.bytes, pkt.len);
+  char text[256];
+  pingFrame f;
+  uint16_t n;
+  if (decodePing(pkt.bytes, pkt.len, f)) n = strlen(formatPing(f, text));
+  else {
+    // Other payloads may be binary: show them as text, dots for the rest.
+    n = pkt.len < sizeof(text) - 1 ? pkt.len : sizeof(text) - 1;
+    for (uint16_t i = 0; i < n; i++) {
+      uint8_t c = pkt.bytes[i];
+      text[i] = c > 31 && c < 127 ? c : '.';
+    }
+    text[n] = 0;
+  }
+  notifyBLE(text);
+  uint16_t py = 72, ix = 0, nChar = 28;
+  while (n - ix > nChar) {
+    char c = text[ix + nChar];
+    text[ix + nChar] = 0;
+    lcd.drawString(text + ix, 2, py, FM9);
+    ix += nChar;
+    text[ix] = c;
+    py += 18;
+  }
+  lcd.drawString(text + ix, 2, py, FM9);
+}
+
 void handleMain1() {
   // SerialUSB.println("handleMain1");
   renderScreen(screen1);
   lcd.setTextWrap(true, true);
-  short length = 0;
-  short rssi, snr;
   bool leaving = false;
-  Serial1.print("AT+TEST=RXLRPKT\r\n");
-  delay(100);
+  // The radio manager keeps RX on; this screen only shows the packets.
+  radioPacketHandler = listenPacket;
 
   while (1) {
     if (digitalRead(WIO_KEY_A) == LOW) {
-      while (digitalRead(WIO_KEY_A) == LOW) ; // debounce
+      while (digitalRead(WIO_KEY_A) == LOW) backgroundTasks(); // debounce
       leaving = true;
     }
     if (digitalRead(WIO_KEY_B) == LOW) {
-      while (digitalRead(WIO_KEY_B) == LOW) ; // debounce
+      while (digitalRead(WIO_KEY_B) == LOW) backgroundTasks(); // debounce
       leaving = true;
     }
     if (digitalRead(WIO_KEY_C) == LOW) {
-      while (digitalRead(WIO_KEY_C) == LOW) ; // debounce
+      while (digitalRead(WIO_KEY_C) == LOW) backgroundTasks(); // debounce
       leaving = true;
     }
     if (leaving) {
+      radioPacketHandler = NULL;
       handleReturnToMain(1);
       return;
     }
-    if (Serial1.available()) {
-      SerialUSB.println("Incoming!");
-      memset(inBuffer, 0, 512);
-      uint16_t ix = 0;
-      while (Serial1.available()) {
-        char c = Serial1.read();
-        delay(5);
-        if (c != 13) inBuffer[ix++] = c;
-        if (ix == 512) ix = 0; // protection against overflow.
-      }
-      hexDump(inBuffer, ix);
-      char *ptr = strstr((char*)inBuffer, "+TEST: LEN:");
-      short number = 0, rssi = 255, snr = 255;
-      if (ptr) number = atoi(ptr + 11);
-      if (number > 0) {
-        drawLoRa(18, 18, 16, TFT_GREEN); // draws the regular LoRa logo in green
-        delay(500);
-        ptr = strstr((char*)inBuffer, "RSSI:");
-        if (ptr)rssi = atoi(ptr + 5);
-        ptr = strstr((char*)inBuffer, "SNR:");
-        if (ptr)snr = atoi(ptr + 4);
-        ptr = strstr((char*)inBuffer, "RX \"");
-        if (ptr) {
-          ptr += 4;
-          lcd.setColor(TFT_WHITE);
-          lcd.fillRect(0, 50, 319, 220);
-          char tmp[128];
-          sprintf(tmp, "Length: %d bytes, RSSI: %d, SNR: %d\n", number, rssi, snr);
-          SerialUSB.print(tmp);
-          notifyBLE(tmp);
-          lcd.drawString(tmp, 4, 50, FSS9);
-          hex2array(ptr, number * 2, (char*)inBuffer);
-          SerialUSB.println((char*)inBuffer);
-          uint16_t py = 72, ix = 0, nChar = 28;
-          notifyBLE((char*)inBuffer);
-          while (strlen((char*)inBuffer + ix) > nChar) {
-            char c = inBuffer[ix + nChar];
-            inBuffer[ix + nChar] = 0;
-            lcd.drawString((char*)inBuffer + ix, 2, py, FM9);
-            ix += nChar;
-            inBuffer[ix] = c;
-            py += 18;
-          }
-          lcd.drawString((char*)inBuffer + ix, 2, py, FM9);
-        }
-        lcd.setColor(TFT_WHITE);
-        lcd.fillRect(0, 0, 32, 32);
-      }
-    }
+    backgroundTasks();
   }
 }
 
@@ -967,13 +1203,13 @@ void drawSlider(myScreen screen) {
   lcd.drawRoundRect(107, 99, 106, 30, 8, TFT_BLUE);
 }
 
-void handleSlider(myScreen screen) {
+void handleSlider(myScreen &screen) {
   renderScreen(screen);
   drawSlider(screen);
   while (true) {
     uint32_t lastSlide = millis();
     if (digitalRead(WIO_5S_LEFT) == LOW) {
-      while (digitalRead(WIO_5S_LEFT) == LOW && millis() - lastSlide < 100) ; // debounce
+      while (digitalRead(WIO_5S_LEFT) == LOW && millis() - lastSlide < 100) backgroundTasks(); // debounce
       int newValue = screen.slider.currentValue - screen.slider.step;
       if (newValue < screen.slider.minValue) newValue = screen.slider.minValue;
       screen.slider.currentValue = newValue;
@@ -981,7 +1217,7 @@ void handleSlider(myScreen screen) {
       drawSlider(screen);
       lastSlide = millis();
     } else if (digitalRead(WIO_5S_RIGHT) == LOW) {
-      while (digitalRead(WIO_5S_RIGHT) == LOW && millis() - lastSlide < 100) ; // debounce
+      while (digitalRead(WIO_5S_RIGHT) == LOW && millis() - lastSlide < 100) backgroundTasks(); // debounce
       int newValue = screen.slider.currentValue + screen.slider.step;
       if (newValue > screen.slider.maxValue) newValue = screen.slider.maxValue;
       screen.slider.currentValue = newValue;
@@ -989,15 +1225,20 @@ void handleSlider(myScreen screen) {
       drawSlider(screen);
       lastSlide = millis();
     } else if (digitalRead(WIO_5S_PRESS) == LOW) {
-      while (digitalRead(WIO_5S_PRESS) == LOW) ; // debounce
+      while (digitalRead(WIO_5S_PRESS) == LOW) backgroundTasks(); // debounce
       return;
     }
+    backgroundTasks();
   }
 }
 
 void handleLuminosity() {
   myScreen previousScreen = currentScreen;
   handleSlider(screenLumi);
+  if (screenLumi.slider.currentValue != luminosity) {
+    luminosity = screenLumi.slider.currentValue;
+    savePrefs();
+  }
   currentScreen = previousScreen;
   renderScreen(currentScreen);
 }
@@ -24,16 +24,70 @@
 #include <KLoRaWan.h> // https://github.com/Kongduino/WioE5_LoRaWAN
 #define LGFX_USE_V1
 #define LGFX_AUTODETECT // LGFX_WIO_TERMINAL // LGFX_AUTODETECT
-#define PING_DELAY 30000
 
 #include <LovyanGFX.hpp>
 #include <LGFX_AUTODETECT.hpp>
 #include "fonts.h"
+// Count heap allocations for the bench command (replaces malloc()).
+// #define GPS_COUNT_ALLOCS
+#include "Hex_Helper.h"
+#include "AT_Helper.h"
 #include "Helper.h"
-#include "UI.h"
 #include "GPS_Helper.h"
+#include "Radio_Helper.h"
+#include "UI.h"
+
+char consoleLine[32];
+uint8_t consoleLen = 0;
+
+void runCommand(char *cmd) {
+  if (strcmp(cmd, "record") == 0) {
+    gpsRecording = true;
+  } else if (strcmp(cmd, "stop") == 0) {
+    gpsRecording = false;
+  } else if (strcmp(cmd, "replay") == 0) {
+    gpsReplayBegin(false);
+  } else if (strcmp(cmd, "bench") == 0) {
+    gpsReplayBegin(true);
+  } else if (strcmp(cmd, "gps") == 0) {
+    GpsFix fix;
+    char tmp[128];
+    getGpsFix(fix);
+    SerialUSB.println(formatGpsFix(fix, tmp));
+    printNMEAStats();
+  } else if (strcmp(cmd, "busywait") == 0 || strcmp(cmd, "timer") == 0) {
+    gps.setRxEngine(cmd[0] == 'b' ? SS_RX_BUSYWAIT : SS_RX_TIMER);
+    gps.begin(gpsBaud);
+    gps.resetRxCycles();
+    gps.resetRxStats();
+  } else if (strcmp(cmd, "rxstats") == 0) {
+    printRxStats();
+  } else if (strcmp(cmd, "rxreset") == 0) {
+    gps.resetRxStats();
+  } else if (strncmp(cmd, "sweep", 5) == 0 && (cmd[5] == 0 || cmd[5] == ' ')) {
+    sweepLink(atol(cmd + 5));
+  } else if (strcmp(cmd, "duty") == 0) {
+    printDuty();
+  } else if (strcmp(cmd, "radio") == 0) {
+    printRadio();
+  } else if (strcmp(cmd, "rxcpu") == 0) {
+    SerialUSB.printf("RX engine: %s, %lu cycles/byte\n", gps.rxEngine() == SS_RX_TIMER ? "timer" : "busywait", gps.rxCyclesPerByte());
+  } else {
+    SerialUSB.println("Commands: record, stop, replay, bench, gps, busywait, timer, rxcpu, rxstats, rxreset, sweep [ppm], duty, radio");
+  }
+}
 
-uint32_t sendTimer;
+void handleConsole() {
+  // While replaying, USB input belongs to the GPS parser.
+  while (!gpsReplaying && SerialUSB.available()) {
+    char c = SerialUSB.read();
+    if (c == 13 || c == 10) {
+      consoleLine[consoleLen] = 0;
+      if (consoleLen > 0) runCommand(consoleLine);
+      consoleLen = 0;
+    } else if (consoleLen < sizeof(consoleLine) - 1) consoleLine[consoleLen++] = c;
+  }
+}
 
 void setup(void) {
   SerialUSB.begin(115200);
@@ -49,25 +103,7 @@ void setup(void) {
   // RNG
   lora.initRandom();
 
-  /*
-    Setting are broken. Will fix ASAP.
-    2023/02/19
-  */
-  savePrefs();
-  uint8_t prefs[16];
-  memset(prefs, 0xFF, 16);
-  for (ix = 0; ix < 16; ix++)
-    prefs[ix] = lora.getEEPROM(ix + 240);
-  hexDump(prefs, 12);
-  float fq;
-  if (memcmp(prefs, "@love", 5) == 0) {
-    SerialUSB.println("Magic word found!");
-    mySF = prefs[5];
-    myBW = prefs[6];
-    myTx = prefs[7];
-    myFreqIndex = prefs[12];
-    memcpy(&myFreq, (prefs + 8), 4);
-  } else savePrefs();
+  loadPrefs();
   SerialUSB.printf("Freq: %.3f\n", myFreq);
   SerialUSB.printf("SF: %d\n", mySF);
   SerialUSB.printf("BW: %d\n", myBW);
@@ -98,16 +134,20 @@ void setup(void) {
   initScreenFreqDecimal();
   initScreenTx();
   initScreenLumi();
+  initScreenGPS();
+  initScreenSerial();
   mainScreen.selectedIndex = 0;
   renderScreen(mainScreen);
   // BLE
   ble_setup();
-  sendTimer = millis();
+  radioTxHandler = showTx;
+  backgroundDraw = pollLoRaLogos;
+  radioBegin();
 }
 
 void loop(void) {
   if (digitalRead(WIO_5S_UP) == LOW) {
-    while (digitalRead(WIO_5S_UP) == LOW) ; // debounce
+    while (digitalRead(WIO_5S_UP) == LOW) backgroundTasks(); // debounce
     char tmp[32];
     sprintf(tmp, "selectedIndex: %d\n", currentScreen.selectedIndex);
     SerialUSB.print(tmp);
@@ -119,7 +159,7 @@ void loop(void) {
     SerialUSB.print(tmp);
     renderScreen(currentScreen);
   } else if (digitalRead(WIO_5S_DOWN) == LOW) {
-    while (digitalRead(WIO_5S_DOWN) == LOW) ; // debounce
+    while (digitalRead(WIO_5S_DOWN) == LOW) backgroundTasks(); // debounce
     char tmp[32];
     sprintf(tmp, "selectedIndex: %d\n", currentScreen.selectedIndex);
     SerialUSB.print(tmp);
@@ -131,7 +171,7 @@ void loop(void) {
     currentScreen.buttons[currentScreen.selectedIndex].button.press(true);
     renderScreen(currentScreen);
   } else if (digitalRead(WIO_5S_PRESS) == LOW) {
-    while (digitalRead(WIO_5S_PRESS) == LOW) ; // debounce
+    while (digitalRead(WIO_5S_PRESS) == LOW) backgroundTasks(); // debounce
     char tmp[32];
     sprintf(tmp, "selectedIndex: %d\n", currentScreen.selectedIndex);
     SerialUSB.print(tmp);
@@ -140,7 +180,7 @@ void loop(void) {
       b0.ptr();
     }
   } else if (digitalRead(WIO_KEY_C) == LOW) {
-    while (digitalRead(WIO_KEY_C) == LOW) ; // debounce
+    while (digitalRead(WIO_KEY_C) == LOW) backgroundTasks(); // debounce
     handleLuminosity();
   }
   // disconnecting
@@ -158,71 +198,6 @@ void loop(void) {
     pTxCharacteristic->notify();
     oldDeviceConnected = deviceConnected;
   }
-  if (millis() - sendTimer > PING_DELAY) {
-    drawLoRa(); // draws the regular LoRa logo in cyan
-    SerialUSB.println("Send hex.");
-    sprintf((char*)inBuffer, "PING #%d.", pingCount++);
-    uint8_t ln = strlen((char*)inBuffer);
-    hexDump(inBuffer, ln);
-    lora.transferPacketP2PMode(inBuffer, ln);
-    lcd.setColor(TFT_WHITE);
-    lcd.fillRect(0, 240 - 40, 36, 40);
-    sendTimer = millis();
-  }
-  if (millis() - lastGPS > GPS_DELAY) {
-    gps.flush();
-    uint32_t t0 = millis();
-    while (millis() - t0 < GPS_DURATION) {
-      if (gps.available()) {
-        char c = gps.read();
-        if (waitForDollar && c == '$') {
-          waitForDollar = false;
-          buffer[0] = '$';
-          ix = 1;
-        } else if (waitForDollar == false) {
-          if (c == 13) {
-            buffer[ix] = 0;
-            c = gps.read();
-            delay(50);
-            string nextLine = string(buffer);
-            userStrings.push_back(nextLine.substr(0, nextLine.size() - 3));
-            waitForDollar = true;
-          } else {
-            buffer[ix++] = c;
-          }
-        }
-      }
-    }
-    if (userStrings.size() > 0) {
-      string nextLine = userStrings[0];
-      userStrings.erase(userStrings.begin());
-      if (nextLine.substr(0, 1) != "$") {
-        // Serial.print("Not an NMEA string!\n>> ");
-        // Serial.println(nextLine.c_str());
-        return;
-      } else {
-        vector<string>result = parseNMEA(nextLine);
-        if (result.size() == 0) return;
-        string verb = result.at(0);
-        if (verb.substr(3, 3) == "RMC") {
-          parseGPRMC(result);
-        } else if (verb.substr(3, 3) == "GSV") {
-          parseGPGSV(result);
-        } else if (verb.substr(3, 3) == "GGA") {
-          parseGPGGA(result);
-        } else if (verb.substr(3, 3) == "GLL") {
-          parseGPGLL(result);
-        } else if (verb.substr(3, 3) == "GSA") {
-          parseGPGSA(result);
-        } else if (verb.substr(3, 3) == "VTG") {
-          parseGPVTG(result);
-        } else if (verb.substr(3, 3) == "TXT") {
-          parseGPTXT(result);
-        } else {
-          Serial.println(nextLine.c_str());
-        }
-      }
-    }
-    lastGPS = millis();
-  }
+  handleConsole();
+  backgroundTasks();
 }
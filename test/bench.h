@@ -0,0 +1,51 @@
+// Timing and allocation counting shared by the benchmarks.
+#pragma once
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct benchRun {
+  std::chrono::steady_clock::time_point start;
+  uint32_t allocs0;
+  double ns; // per item
+  double allocs; // per item
+};
+
+void benchStart(benchRun &run) {
+  run.allocs0 = heapAllocs;
+  run.start = std::chrono::steady_clock::now();
+}
+
+void benchStop(benchRun &run, size_t items) {
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - run.start).count();
+  run.ns = ns / items;
+  run.allocs = (double)(heapAllocs - run.allocs0) / items;
+}
+
+void benchPrint(const char *name, const benchRun &run) {
+  printf("  %-24s %9.1f ns %7.2f allocations\n", name, run.ns, run.allocs);
+}
+
+std::string readFile(const char *path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    fprintf(stderr, "can't read %s\n", path);
+    exit(2);
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+// The sentences of a capture whose checksums match, as the framer hands
+// them to the parsers: no CR/LF, no *hh.
+std::vector<std::string> readSentences(const char *path) {
+  std::string bytes = readFile(path);
+  std::vector<std::string> lines;
+  nmeaFramer fr = {{0}, 0, NMEA_IDLE, 0, 0};
+  for (char c : bytes)
+    if (nmeaFeed(fr, c) == NMEA_VALID) lines.push_back(std::string(fr.line, fr.len));
+  return lines;
+}
@@ -0,0 +1,95 @@
+// parseDegrees() against an exact reference: the whole digit string in
+// 128-bit integers, rounded half up once. Random terms of every length,
+// exact ties, and the malformed ones it must reject. Also reports how
+// far the old float parser strayed on the same terms.
+#include <Arduino.h>
+#include "Hex_Helper.h"
+#include "GPS_Helper.h"
+#include "legacy.h"
+#include <random>
+
+typedef __int128 int128;
+
+// Degrees x 1e7 for "ddmm.ffff", up to 20 fraction digits.
+int64_t reference(const std::string &term) {
+  size_t dot = term.find('.');
+  std::string whole = term.substr(0, dot), fraction = dot == std::string::npos ? "" : term.substr(dot + 1);
+  int64_t w = atoll(whole.c_str());
+  int128 scale = 1, minutes = w % 100; // minutes x 10^digits
+  for (char c : fraction) {
+    scale *= 10;
+    minutes = minutes * 10 + (c - '0');
+  }
+  // round(minutes * 1e7 / 60 / scale), half up
+  int128 num = minutes * 10000000 * 2 + 60 * scale, den = 120 * scale;
+  return (w / 100) * 10000000LL + (int64_t)(num / den);
+}
+
+int failures = 0;
+
+void check(const std::string &term) {
+  int32_t value;
+  if (!parseDegrees({term.c_str(), (uint8_t)term.size()}, value)) {
+    printf("FAIL: %s rejected\n", term.c_str());
+    failures++;
+  } else if (value != reference(term)) {
+    printf("FAIL: %s gave %d, expected %lld\n", term.c_str(), value, (long long)reference(term));
+    failures++;
+  }
+}
+
+void reject(const char *term) {
+  int32_t value;
+  if (parseDegrees({term, (uint8_t)strlen(term)}, value)) {
+    printf("FAIL: %s accepted\n", term);
+    failures++;
+  }
+}
+
+std::string digits(std::mt19937_64 &rng, int n) {
+  std::string s;
+  for (int i = 0; i < n; i++) s += '0' + rng() % 10;
+  return s;
+}
+
+int main() {
+  std::mt19937_64 rng(5);
+  double legacyMax = 0;
+  check("14624.27515097"); // 9 digits: rounding the 8th first was off by one
+  check("2219.16248");
+  check("00000.0000000");
+  check("18000.0000000");
+  check("0000.5");
+  check("4807.038");
+  check("12");
+  check("12.");
+  for (int n = 0; n < 2000000; n++) {
+    char whole[8];
+    bool longitude = rng() & 1;
+    sprintf(whole, longitude ? "%03d%02d" : "%02d%02d", (int)(rng() % (longitude ? 180 : 90)), (int)(rng() % 60));
+    std::string term = std::string(whole) + "." + digits(rng, rng() % 21);
+    check(term);
+    double exact = reference(term) / 1e7, old = legacy::parseDegrees(term.c_str());
+    if (fabs(old - exact) > legacyMax) legacyMax = fabs(old - exact);
+  }
+  // Exact ties: minutes = (2k + 1) x 3e-6 lands on k + 0.5 units of 1e-7
+  // degree. Trailing zeros past the 10th digit must not change that.
+  for (int n = 0; n < 200000; n++) {
+    uint64_t k = rng() % 9999999, m = (2 * k + 1) * 3; // minutes x 1e6
+    char term[40];
+    sprintf(term, "%03d%02llu.%06llu", (int)(rng() % 180), (unsigned long long)(m / 1000000), (unsigned long long)(m % 1000000));
+    check(std::string(term) + std::string(rng() % 15, '0'));
+  }
+  reject("");
+  reject("18001.0");
+  reject("4294967300.0"); // wraps a uint32_t to 4
+  reject("123456.0");
+  reject("4260.0");
+  reject("17999.5");
+  reject("12a4.5");
+  reject("1234.5x");
+  reject("1234.5.6");
+  reject("-1234.5");
+  printf("parseDegrees: %s, old float parser off by up to %.7f degrees\n", failures ? "FAILED" : "exact", legacyMax);
+  return failures != 0;
+}
@@ -0,0 +1,45 @@
+// Cost of picking the parser for a sentence: the old substr() chain,
+// given the tokens it worked from, against nmeaLookup() on the raw line.
+// Also checks both pick the same parser for every GP sentence.
+#include <Arduino.h>
+#include "Hex_Helper.h"
+#include "GPS_Helper.h"
+#include "legacy.h"
+#include "bench.h"
+
+int lookupIndex(nmeaHandler handler) {
+  const nmeaHandler handlers[] = {NULL, parseGPRMC, parseGPGSV, parseGPGGA, parseGPGLL, parseGPGSA, parseGPVTG, parseGPTXT};
+  for (int i = 0; i < 8; i++)
+    if (handlers[i] == handler) return i;
+  return -1;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> lines = readSentences(argc > 1 ? argv[1] : "data/sample.nmea");
+  std::vector<vector<string>> tokens;
+  for (const std::string &line : lines) {
+    tokens.push_back(legacy::parseNMEA(line));
+    if (line.compare(1, 2, "GP") == 0 && legacy::dispatchNMEA(tokens.back()) != lookupIndex(nmeaLookup(line.c_str() + 1))) {
+      printf("FAIL: %s dispatches differently\n", line.c_str());
+      return 1;
+    }
+  }
+  const int rounds = 2000;
+  volatile uintptr_t sink = 0;
+  benchRun legacyRun, newRun;
+
+  benchStart(legacyRun);
+  for (int r = 0; r < rounds; r++)
+    for (const vector<string> &result : tokens) sink += legacy::dispatchNMEA(result);
+  benchStop(legacyRun, rounds * lines.size());
+
+  benchStart(newRun);
+  for (int r = 0; r < rounds; r++)
+    for (const std::string &line : lines) sink += (uintptr_t)nmeaLookup(line.c_str() + 1);
+  benchStop(newRun, rounds * lines.size());
+
+  printf("dispatch, %zu sentences x %d\n", lines.size(), rounds);
+  benchPrint("substr() chain", legacyRun);
+  benchPrint("nmeaLookup()", newRun);
+  return 0;
+}
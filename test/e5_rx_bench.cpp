@@ -0,0 +1,101 @@
+// e5RxFeed() over an E5 receive transcript: checks every packet against
+// a plain decode of the same text, then times it per byte against the
+// Listen screen's old buffer-everything-then-strstr() parsing. The old
+// side is handed each packet's two lines already split out, so it does
+// no framing and never sees a bad packet; it still needs the whole text
+// held in RAM, which e5RxFeed() doesn't.
+#include <Arduino.h>
+#include "Hex_Helper.h"
+#include "GPS_Helper.h"
+#include "AT_Helper.h"
+#include "legacy.h"
+#include "bench.h"
+
+struct expectedPacket {
+  std::vector<uint8_t> bytes;
+  int rssi, snr;
+};
+
+// Packets in the transcript whose hex is good and matches the LEN line
+// before it, decoded with the C library. Also splits the transcript into
+// one chunk per packet, its LEN and RX lines, as the old code read them.
+std::vector<expectedPacket> decodeTranscript(const std::string &text, std::vector<std::string> &chunks) {
+  std::vector<expectedPacket> packets;
+  int len = -1, rssi = 0, snr = 0;
+  size_t start = 0, eol, info = 0;
+  while ((eol = text.find('\n', start)) != std::string::npos) {
+    std::string line = text.substr(start, eol - start);
+    if (line.size() && line.back() == '\r') line.pop_back();
+    if (sscanf(line.c_str(), "+TEST: LEN:%d, RSSI:%d, SNR:%d", &len, &rssi, &snr) == 3) info = start;
+    else if (line.compare(0, 11, "+TEST: RX \"") == 0) {
+      std::string hex = line.substr(11, line.size() - 12);
+      bool good = len >= 0 && hex.size() == 2 * (size_t)len && hex.find_first_not_of("0123456789ABCDEFabcdef") == std::string::npos;
+      if (good) {
+        expectedPacket p = {{}, rssi, snr};
+        for (size_t i = 0; i < hex.size(); i += 2) p.bytes.push_back(strtoul(hex.substr(i, 2).c_str(), NULL, 16));
+        packets.push_back(p);
+        chunks.push_back(text.substr(info, eol + 1 - info));
+      }
+      len = -1;
+    }
+    start = eol + 1;
+  }
+  return packets;
+}
+
+int main(int argc, char **argv) {
+  std::string text = readFile(argc > 1 ? argv[1] : "data/e5_rx.txt");
+  std::vector<std::string> chunks;
+  std::vector<expectedPacket> expected = decodeTranscript(text, chunks);
+  uint8_t buf[256];
+  e5RxParser p;
+  e5RxBegin(p, buf, sizeof(buf));
+  size_t n = 0;
+  for (char c : text) {
+    if (e5RxFeed(p, c) != E5RX_PACKET) continue;
+    if (n >= expected.size()) {
+      printf("FAIL: more packets than the transcript has\n");
+      return 1;
+    }
+    const expectedPacket &e = expected[n];
+    if (p.packet.len != e.bytes.size() || memcmp(p.packet.bytes, e.bytes.data(), e.bytes.size()) != 0 ||
+        p.packet.rssi != e.rssi || p.packet.snr != e.snr || p.packet.truncated) {
+      printf("FAIL: packet %zu doesn't match the transcript\n", n);
+      return 1;
+    }
+    n++;
+  }
+  if (n != expected.size() || p.errors != 2) {
+    printf("FAIL: %zu packets, %lu errors; expected %zu and 2\n", n, (unsigned long)p.errors, expected.size());
+    return 1;
+  }
+
+  const int rounds = 2000;
+  volatile uint32_t sink = 0;
+  benchRun legacyRun, newRun;
+  size_t bytes = 0;
+  for (const std::string &chunk : chunks) bytes += chunk.size();
+  static char inBuffer[1024];
+  benchStart(legacyRun);
+  for (int r = 0; r < rounds; r++)
+    for (const std::string &chunk : chunks) {
+      memset(inBuffer, 0, 512);
+      uint16_t ix = 0;
+      for (char c : chunk)
+        if (c != 13) inBuffer[ix++] = c;
+      short rssi, snr;
+      sink += legacy::parseRx(inBuffer, rssi, snr) + inBuffer[0];
+    }
+  benchStop(legacyRun, rounds * bytes);
+  benchStart(newRun);
+  for (int r = 0; r < rounds; r++)
+    for (const std::string &chunk : chunks)
+      for (char c : chunk)
+        if (e5RxFeed(p, c) == E5RX_PACKET) sink += p.packet.bytes[0];
+  benchStop(newRun, rounds * bytes);
+
+  printf("E5 receive, %zu packets, %zu bytes x %d, per byte\n", n, bytes, rounds);
+  benchPrint("buffer + strstr()", legacyRun);
+  benchPrint("e5RxFeed()", newRun);
+  return 0;
+}
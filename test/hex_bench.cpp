@@ -0,0 +1,107 @@
+// The hex codec against what it replaced: hexDump() output against the
+// old dump, hexEncode()/hexDecode() against sprintf() at every length up
+// to 300 bytes, then cost per byte at 64, 255 and 512 bytes (a short
+// payload, the E5's largest, and a dump-sized buffer). Encoding had no
+// helper before; sprintf("%02X") stands in for it. The host SerialUSB
+// stores output a byte at a time, which dominates both dumps here.
+#include <Arduino.h>
+#include "Hex_Helper.h"
+#include "GPS_Helper.h"
+#include "legacy.h"
+#include "bench.h"
+
+// The old dump printed lowercase digits; the new one uppercase. Row
+// lines are raised to compare the rest, the ASCII column excepted.
+std::string upperDigits(std::string dump) {
+  size_t start = 0, eol;
+  while ((eol = dump.find('\n', start)) != std::string::npos) {
+    size_t bar = dump.find('|', start);
+    if (dump.compare(start, 4, "   +") != 0 && dump.compare(start, 4, "   |") != 0)
+      for (size_t i = bar + 1; i < bar + 49; i++) dump[i] = toupper(dump[i]);
+    start = eol + 1;
+  }
+  return dump;
+}
+
+std::string captureDump(void (*dump)(uint8_t*, uint16_t), uint8_t *buf, uint16_t len) {
+  SerialUSB.out.clear();
+  dump(buf, len);
+  return SerialUSB.out;
+}
+
+int main() {
+  static uint8_t buf[4100], back[512];
+  static char hex[8201], ref[8201];
+  for (uint8_t &b : buf) b = rand();
+  SerialUSB.capture = true;
+  for (uint16_t len : {0, 1, 15, 16, 17, 127, 128, 129, 255, 256, 512, 4100})
+    if (captureDump(hexDump, buf, len) != upperDigits(captureDump(legacy::hexDump, buf, len))) {
+      printf("FAIL: hexDump() of %u bytes differs from the old dump\n", len);
+      return 1;
+    }
+  for (size_t len = 0; len <= 300; len++) {
+    for (size_t i = 0; i < len; i++) sprintf(ref + 2 * i, "%02X", buf[i]);
+    if (hexEncode(buf, len, hex) != hex + 2 * len || memcmp(hex, ref, 2 * len) != 0 || hex[2 * len] != 0) {
+      printf("FAIL: hexEncode() of %zu bytes differs from sprintf()\n", len);
+      return 1;
+    }
+    if (hexDecode(hex, 2 * len, back) != (int)len || memcmp(back, buf, len) != 0) {
+      printf("FAIL: hexDecode() of %zu bytes doesn't round trip\n", len);
+      return 1;
+    }
+  }
+  if (hexDecode("0aFf", 4, back) != 2 || back[0] != 0x0A || back[1] != 0xFF || hexDecode("0g", 2, back) != -1 ||
+      hexDecode("abc", 3, back) != -1) {
+    printf("FAIL: hexDecode() on mixed case, bad digits or an odd length\n");
+    return 1;
+  }
+
+  volatile uint32_t sink = 0;
+  // Dumps go to a string reserved up front, so printing doesn't allocate.
+  SerialUSB.out.reserve(16 * 1024);
+  for (uint16_t len : {64, 255, 512}) {
+    const int rounds = 4000000 / len;
+    benchRun run;
+    hexEncode(buf, len, hex);
+    printf("%u bytes, per byte\n", len);
+    benchStart(run);
+    for (int r = 0; r < rounds; r++) {
+      legacy::hex2array(hex, 2 * len, (char*)back);
+      sink += back[r % len];
+    }
+    benchStop(run, (size_t)rounds * len);
+    benchPrint("decode: hex2array()", run);
+    benchStart(run);
+    for (int r = 0; r < rounds; r++) sink += hexDecode(hex, 2 * len, back);
+    benchStop(run, (size_t)rounds * len);
+    benchPrint("decode: hexDecode()", run);
+    benchStart(run);
+    for (int r = 0; r < rounds; r++) {
+      for (uint16_t i = 0; i < len; i++) sprintf(ref + 2 * i, "%02X", buf[i]);
+      sink += ref[r % len];
+    }
+    benchStop(run, (size_t)rounds * len);
+    benchPrint("encode: sprintf()", run);
+    benchStart(run);
+    for (int r = 0; r < rounds; r++) sink += *hexEncode(buf, len, hex);
+    benchStop(run, (size_t)rounds * len);
+    benchPrint("encode: hexEncode()", run);
+    benchStart(run);
+    for (int r = 0; r < rounds / 16; r++) {
+      SerialUSB.out.clear();
+      legacy::hexDump(buf, len);
+      sink += SerialUSB.out.size();
+    }
+    benchStop(run, (size_t)rounds / 16 * len);
+    benchPrint("dump: old hexDump()", run);
+    benchStart(run);
+    for (int r = 0; r < rounds / 16; r++) {
+      SerialUSB.out.clear();
+      hexDump(buf, len);
+      sink += SerialUSB.out.size();
+    }
+    benchStop(run, (size_t)rounds / 16 * len);
+    benchPrint("dump: hexDump()", run);
+  }
+  return 0;
+}
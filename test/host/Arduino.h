@@ -0,0 +1,38 @@
+// Host stand-in for the Arduino core: just enough for the sketch's
+// helpers to build and run on Linux, see "Host tests" in README.md.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Stream.h"
+#include "variant.h"
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+#define NOT_AN_INTERRUPT -1
+
+// Time comes from hostMicros(), the wall clock unless a test supplies
+// its own (all the clock functions in hw.cpp are weak).
+uint64_t hostMicros();
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void attachInterrupt(int pin, void (*handler)(), int mode);
+void noInterrupts();
+void interrupts();
+
+// malloc() calls so far, see hw.cpp.
+extern volatile uint32_t heapAllocs;
@@ -0,0 +1,118 @@
+// Host stand-in for Print/Stream. A HostSerial reads from `in` and
+// writes to stdout, or to `out` when capturing.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+
+#define F(x) x
+#define DEC 10
+#define HEX 16
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+      for (size_t i = 0; i < size; i++) write(buffer[i]);
+      return size;
+    }
+    size_t write(const char *s) {
+      return write((const uint8_t*)s, strlen(s));
+    }
+    size_t write(const char *buffer, size_t size) {
+      return write((const uint8_t*)buffer, size);
+    }
+    size_t print(const char *s) {
+      return write(s);
+    }
+    size_t print(char c) {
+      return write((uint8_t)c);
+    }
+    size_t print(const std::string &s) {
+      return write(s.c_str());
+    }
+    size_t print(long v, int base = DEC) {
+      char tmp[24];
+      snprintf(tmp, sizeof(tmp), base == HEX ? "%lX" : "%ld", v);
+      return write(tmp);
+    }
+    size_t print(int v, int base = DEC) {
+      return print((long)v, base);
+    }
+    size_t print(unsigned long v, int base = DEC) {
+      char tmp[24];
+      snprintf(tmp, sizeof(tmp), base == HEX ? "%lX" : "%lu", v);
+      return write(tmp);
+    }
+    size_t print(unsigned int v, int base = DEC) {
+      return print((unsigned long)v, base);
+    }
+    size_t print(double v, int digits = 2) {
+      char tmp[48];
+      snprintf(tmp, sizeof(tmp), "%.*f", digits, v);
+      return write(tmp);
+    }
+    size_t println() {
+      return write("\r\n");
+    }
+    template <typename T> size_t println(T v) {
+      return print(v) + println();
+    }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+      char tmp[1024];
+      va_list args;
+      va_start(args, format);
+      int n = vsnprintf(tmp, sizeof(tmp), format, args);
+      va_end(args);
+      return write((const uint8_t*)tmp, n < (int)sizeof(tmp) ? n : sizeof(tmp) - 1);
+    }
+    void setWriteError() {}
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+class HostSerial : public Stream {
+  public:
+    std::string in, out;
+    size_t pos = 0;
+    bool capture = false;
+    void begin(long) {}
+    size_t write(uint8_t c) override {
+      if (capture) out += (char)c;
+      else fputc(c, stdout);
+      return 1;
+    }
+    using Print::write;
+    int available() override {
+      return in.size() - pos;
+    }
+    int read() override {
+      return pos < in.size() ? (uint8_t)in[pos++] : -1;
+    }
+    int peek() override {
+      return pos < in.size() ? (uint8_t)in[pos] : -1;
+    }
+    // Queues bytes for read(), dropping what was already read.
+    void feed(const std::string &bytes) {
+      in.erase(0, pos);
+      pos = 0;
+      in += bytes;
+    }
+    operator bool() {
+      return true;
+    }
+};
+
+extern HostSerial SerialUSB, Serial1;
+// As on the Wio Terminal, Serial is the USB port.
+#define Serial SerialUSB
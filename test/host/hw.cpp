@@ -0,0 +1,88 @@
+// Storage for the host stand-ins. The time, pin, register and interrupt
+// hooks are weak so a test can drive them from a simulated clock.
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+
+HostSerial SerialUSB, Serial1;
+
+static PortGroup port;
+static EIC_t eic;
+static GCLK_t gclk;
+static Tc tc3, tc4;
+static DWT_t dwt;
+static CoreDebug_t coreDebug;
+PinDescription g_APinDescription[64];
+EIC_t *EIC = &eic;
+GCLK_t *GCLK = &gclk;
+Tc *TC3 = &tc3, *TC4 = &tc4;
+DWT_t *DWT = &dwt;
+CoreDebug_t *CoreDebug = &coreDebug;
+
+PortGroup *digitalPinToPort(int) {
+  return &port;
+}
+
+uint32_t digitalPinToBitMask(int pin) {
+  return 1UL << (pin & 31);
+}
+
+__attribute__((weak)) uint64_t hostMicros() {
+  static auto t0 = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+__attribute__((weak)) uint32_t hostCycles() {
+  static auto t0 = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count() * (F_CPU / 1000000) / 1000;
+}
+
+__attribute__((weak)) void hostRegWrite(const volatile void *, uint32_t) {}
+
+__attribute__((weak)) uint32_t hostPinRead() {
+  return 0xFFFFFFFF; // idle line
+}
+
+unsigned long millis() {
+  return hostMicros() / 1000;
+}
+
+unsigned long micros() {
+  return hostMicros();
+}
+
+__attribute__((weak)) void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+__attribute__((weak)) void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(int, int) {}
+void digitalWrite(int, int) {}
+int digitalRead(int) {
+  return HIGH;
+}
+__attribute__((weak)) void attachInterrupt(int, void (*)(), int) {}
+void noInterrupts() {}
+void interrupts() {}
+void NVIC_SetPriority(IRQn_Type, uint32_t) {}
+void NVIC_EnableIRQ(IRQn_Type) {}
+void NVIC_DisableIRQ(IRQn_Type) {}
+void NVIC_ClearPendingIRQ(IRQn_Type) {}
+
+// Counts every malloc(), operator new included, so a test can tell
+// whether code under test touched the heap.
+volatile uint32_t heapAllocs = 0;
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void __libc_free(void *ptr);
+
+extern "C" void *malloc(size_t size) {
+  heapAllocs++;
+  return __libc_malloc(size);
+}
+
+extern "C" void free(void *ptr) {
+  __libc_free(ptr);
+}
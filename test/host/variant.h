@@ -0,0 +1,134 @@
+// Host stand-in for the SAMD51 registers SoftwareSerial1.cpp touches.
+// Writes land in memory and are reported to hostRegWrite(); the pin
+// input and the DWT cycle counter read through hostPinRead() and
+// hostCycles(). All three are weak, for a test to replace.
+#pragma once
+#include <stdint.h>
+
+#define F_CPU 120000000UL
+#define SystemCoreClock F_CPU
+#define ARDUINO_SAMD_VARIANT_COMPLIANCE 10607
+
+uint32_t hostPinRead();
+uint32_t hostCycles();
+void hostRegWrite(const volatile void *reg, uint32_t value);
+
+struct HostRegValue {
+  uint32_t value;
+  operator uint32_t() const volatile {
+    return value;
+  }
+  void operator=(uint32_t v) volatile {
+    value = v;
+    hostRegWrite(this, v);
+  }
+  void operator|=(uint32_t v) volatile {
+    *this = value | v;
+  }
+  void operator&=(uint32_t v) volatile {
+    *this = value & v;
+  }
+};
+
+struct HostReg {
+  HostRegValue reg;
+  struct {
+    uint32_t ENABLE: 1, SWRST: 1, CC0: 1, CC1: 1, CTRLB: 1, COUNT: 1;
+  } bit;
+};
+struct HostPin {
+  struct {
+    operator uint32_t() const volatile {
+      return hostPinRead();
+    }
+  } reg;
+};
+struct HostCycles {
+  operator uint32_t() const volatile {
+    return hostCycles();
+  }
+};
+
+typedef HostReg PORT_OUT_Type, PORT_DIR_Type;
+typedef HostPin PORT_IN_Type;
+struct PortGroup {
+  PORT_DIR_Type DIR;
+  PORT_OUT_Type OUT;
+  PORT_IN_Type IN;
+};
+PortGroup *digitalPinToPort(int pin);
+uint32_t digitalPinToBitMask(int pin);
+struct PinDescription {
+  int ulExtInt;
+};
+extern PinDescription g_APinDescription[];
+typedef int EExt_Interrupts;
+
+typedef int IRQn_Type;
+#define EIC_0_IRQn 12
+#define TC3_IRQn 110
+#define TC4_IRQn 111
+#define TC3_GCLK_ID 26
+#define TC4_GCLK_ID 30
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+
+struct EIC_t {
+  HostReg INTENCLR, INTENSET, INTFLAG;
+};
+extern EIC_t *EIC;
+#define EIC_INTENCLR_EXTINT(x) (x)
+#define EIC_INTENSET_EXTINT(x) (x)
+
+struct GCLK_t {
+  HostReg PCHCTRL[48];
+};
+extern GCLK_t *GCLK;
+#define GCLK_PCHCTRL_GEN_GCLK1 0x01
+#define GCLK_PCHCTRL_CHEN 0x40
+
+struct TcCount16 {
+  HostReg CTRLA, WAVE, CTRLBSET, CTRLBCLR, INTENSET, INTENCLR, INTFLAG, COUNT, SYNCBUSY;
+  HostReg CC[2];
+};
+struct Tc {
+  TcCount16 COUNT16;
+};
+extern Tc *TC3, *TC4;
+#define TC_CTRLA_SWRST 0x01
+#define TC_CTRLA_ENABLE 0x02
+#define TC_CTRLA_MODE_COUNT16 0x00
+#define TC_CTRLA_PRESCALER_DIV1 0x00
+#define TC_WAVE_WAVEGEN_MFRQ 0x01
+#define TC_CTRLBSET_DIR 0x01
+#define TC_CTRLBSET_ONESHOT 0x04
+#define TC_CTRLBSET_CMD_RETRIGGER 0x20
+#define TC_CTRLBSET_CMD_STOP 0x40
+#define TC_CTRLBSET_CMD_READSYNC 0x80
+#define TC_INTENSET_OVF 0x01
+#define TC_INTENCLR_OVF 0x01
+#define TC_INTFLAG_OVF 0x01
+#define TC_INTENSET_MC0 0x10
+#define TC_INTENCLR_MC0 0x10
+#define TC_INTFLAG_MC0 0x10
+
+struct DWT_t {
+  HostCycles CYCCNT;
+  uint32_t CTRL;
+};
+extern DWT_t *DWT;
+#define DWT_CTRL_CYCCNTENA_Msk 0x01
+struct CoreDebug_t {
+  uint32_t DEMCR;
+};
+extern CoreDebug_t *CoreDebug;
+#define CoreDebug_DEMCR_TRCENA_Msk 0x01000000
+
+// Cheap on a Cortex-M4, where a full fence on x86 would swamp what the
+// benchmarks measure. x86 keeps stores and loads in order anyway.
+#define __DMB() __asm__ __volatile__("" ::: "memory")
+#define __disable_irq()
+#define __enable_irq()
+#define __get_PRIMASK() 0
@@ -0,0 +1,168 @@
+// The parsers as they were before the zero-copy rework, kept verbatim so
+// the benchmarks compare against the code they replaced.
+#pragma once
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace legacy {
+
+float parseDegrees(const char *term) {
+  float value = (float)(atof(term) / 100.0);
+  uint16_t left = (uint16_t)value;
+  value = (value - left) * 1.66666666666666;
+  value += left;
+  return value;
+}
+
+vector<string> parseNMEA(string nmea) {
+  vector<string>result;
+  if (nmea.at(0) != '$') {
+    Serial.println("Not an NMEA sentence!");
+    return result;
+  }
+  size_t lastFound = 0;
+  size_t found = nmea.find(",", lastFound);
+  while (found < nmea.size() && found != string::npos) {
+    string token = nmea.substr(lastFound, found - lastFound);
+    result.push_back(token);
+    lastFound = found + 1;
+    found = nmea.find(",", lastFound);
+  }
+  string token = nmea.substr(lastFound, found - lastFound);
+  result.push_back(token);
+  lastFound = found + 1;
+  found = nmea.find(",", lastFound);
+  return result;
+}
+
+// SoftwareSerial's receive ring before it went to free-running masked
+// indices: modulo arithmetic on every store and read.
+struct modRing {
+  char _receive_buffer[_SS_MAX_RX_BUFF];
+  volatile uint16_t _receive_buffer_tail = 0;
+  volatile uint16_t _receive_buffer_head = 0;
+  bool _buffer_overflow = false;
+
+  void store(uint8_t d) {
+    // if buffer full, set the overflow flag and return
+    uint16_t next = (_receive_buffer_tail + 1) % _SS_MAX_RX_BUFF;
+    if (next != _receive_buffer_head) {
+      // save new data in buffer: tail points to where byte goes
+      _receive_buffer[_receive_buffer_tail] = d; // save new byte
+      _receive_buffer_tail = next;
+    } else {
+      _buffer_overflow = true;
+    }
+  }
+
+  int read() {
+    // Empty buffer?
+    if (_receive_buffer_head == _receive_buffer_tail) return -1;
+    // Read from "head"
+    uint8_t d = _receive_buffer[_receive_buffer_head]; // grab next byte
+    _receive_buffer_head = (_receive_buffer_head + 1) % _SS_MAX_RX_BUFF;
+    return d;
+  }
+
+  int available() {
+    return (_receive_buffer_tail + _SS_MAX_RX_BUFF - _receive_buffer_head) % _SS_MAX_RX_BUFF;
+  }
+};
+
+void hex2array(char *src, size_t sLen, char *dst) {
+  size_t i, n = 0;
+  for (i = 0; i < sLen; i += 2) {
+    uint8_t x, c;
+    c = src[i];
+    if (c > 0x39) c -= 55;
+    else c -= 0x30;
+    x = c << 4;
+    c = src[i + 1];
+    if (c > 0x39) c -= 55;
+    else c -= 0x30;
+    dst[n++] = (x + c);
+  }
+  dst[n] = 0;
+}
+
+void hexDump(uint8_t* buf, uint16_t len) {
+  // Something similar to the Unix/Linux hexdump -C command
+  // Pretty-prints the contents of a buffer, 16 bytes a row
+  char alphabet[17] = "0123456789abcdef";
+  uint16_t i, index;
+  SerialUSB.print(F("   +------------------------------------------------+ +----------------+\n"));
+  SerialUSB.print(F("   |.0 .1 .2 .3 .4 .5 .6 .7 .8 .9 .a .b .c .d .e .f | |      ASCII     |\n"));
+  for (i = 0; i < len; i += 16) {
+    if (i % 128 == 0) SerialUSB.print(F("   +------------------------------------------------+ +----------------+\n"));
+    char s[] = "|                                                | |                |\n";
+    // pre-formated line. We will replace the spaces with text when appropriate.
+    uint8_t ix = 1, iy = 52, j;
+    for (j = 0; j < 16; j++) {
+      if (i + j < len) {
+        uint8_t c = buf[i + j];
+        // fastest way to convert a byte to its 2-digit hex equivalent
+        s[ix++] = alphabet[(c >> 4) & 0x0F];
+        s[ix++] = alphabet[c & 0x0F];
+        ix++;
+        if (c > 31 && c < 128) s[iy++] = c;
+        else s[iy++] = '.'; // display ASCII code 0x20-0x7F or a dot.
+      }
+    }
+    index = i >> 4;
+    // display line number then the text
+    if (i < 256) Serial.write(' ');
+    SerialUSB.print(index, HEX); Serial.write('.');
+    SerialUSB.print(s);
+  }
+  SerialUSB.print(F("   +------------------------------------------------+ +----------------+\n"));
+}
+
+// The Listen screen's packet parsing, minus the drawing: everything that
+// arrived, CRs dropped, searched for the LEN, RSSI and SNR, and the hex
+// decoded in place. It had a 512-byte buffer, which a 255-byte packet
+// overflows; callers here give it room.
+short parseRx(char *inBuffer, short &rssi, short &snr) {
+  char *ptr = strstr((char*)inBuffer, "+TEST: LEN:");
+  short number = 0;
+  rssi = 255, snr = 255;
+  if (ptr) number = atoi(ptr + 11);
+  if (number > 0) {
+    ptr = strstr((char*)inBuffer, "RSSI:");
+    if (ptr)rssi = atoi(ptr + 5);
+    ptr = strstr((char*)inBuffer, "SNR:");
+    if (ptr)snr = atoi(ptr + 4);
+    ptr = strstr((char*)inBuffer, "RX \"");
+    if (ptr) {
+      ptr += 4;
+      hex2array(ptr, number * 2, (char*)inBuffer);
+    }
+  }
+  return number;
+}
+
+// The loop()'s dispatch chain, returning which parser it picked (0 for
+// none) instead of calling it.
+int dispatchNMEA(const vector<string> &result) {
+  string verb = result.at(0);
+  if (verb.substr(3, 3) == "RMC") {
+    return 1;
+  } else if (verb.substr(3, 3) == "GSV") {
+    return 2;
+  } else if (verb.substr(3, 3) == "GGA") {
+    return 3;
+  } else if (verb.substr(3, 3) == "GLL") {
+    return 4;
+  } else if (verb.substr(3, 3) == "GSA") {
+    return 5;
+  } else if (verb.substr(3, 3) == "VTG") {
+    return 6;
+  } else if (verb.substr(3, 3) == "TXT") {
+    return 7;
+  } else {
+    return 0;
+  }
+}
+
+}
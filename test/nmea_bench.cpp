@@ -0,0 +1,44 @@
+// Tokenizer cost per sentence, old vector<string> parseNMEA against the
+// zero-copy one, over a recorded capture. Each old handler took the
+// vector by value, so the legacy side pays for that copy too.
+#include <Arduino.h>
+#include "Hex_Helper.h"
+#include "GPS_Helper.h"
+#include "legacy.h"
+#include "bench.h"
+
+size_t legacyHandler(vector<string> result) {
+  return result.size();
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> lines = readSentences(argc > 1 ? argv[1] : "data/sample.nmea");
+  const int rounds = 200;
+  volatile size_t sink = 0;
+  benchRun legacyRun, newRun;
+
+  benchStart(legacyRun);
+  for (int r = 0; r < rounds; r++)
+    for (const std::string &line : lines) {
+      vector<string> result = legacy::parseNMEA(line);
+      sink += legacyHandler(result);
+    }
+  benchStop(legacyRun, rounds * lines.size());
+
+  benchStart(newRun);
+  for (int r = 0; r < rounds; r++)
+    for (const std::string &line : lines) {
+      nmeaFields result;
+      sink += parseNMEA(line.c_str(), line.size(), result);
+    }
+  benchStop(newRun, rounds * lines.size());
+
+  printf("parseNMEA, %zu sentences x %d\n", lines.size(), rounds);
+  benchPrint("vector<string>", legacyRun);
+  benchPrint("nmeaFields", newRun);
+  if (newRun.allocs != 0) {
+    printf("FAIL: the tokenizer allocated\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,13 @@
+// Puts bytes into a SoftwareSerial's receive ring as its interrupt
+// would, without a pin to bit-bang.
+#pragma once
+#include "SoftwareSerial1.h"
+
+struct SoftwareSerialProbe {
+  static void store(SoftwareSerial &port, uint8_t d) {
+    port.store(d);
+  }
+  static const SoftwareSerialStats &stats(SoftwareSerial &port) {
+    return port._stats;
+  }
+};
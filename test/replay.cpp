@@ -0,0 +1,56 @@
+// The console's replay on Linux: runs a capture through gpsReplayPoll()
+// and prints what the sketch would print. With --golden, compares the
+// FIX lines and counters against a previous run instead, and fails if
+// anything differs or the parsers allocated.
+//   replay [--quiet] [--golden expected.txt] capture.nmea
+#include <Arduino.h>
+#include "Hex_Helper.h"
+#include "GPS_Helper.h"
+#include "bench.h"
+#include <algorithm>
+
+int main(int argc, char **argv) {
+  const char *golden = NULL, *capture = NULL;
+  bool quiet = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) golden = argv[++i];
+    else if (strcmp(argv[i], "--quiet") == 0) quiet = true;
+    else capture = argv[i];
+  }
+  if (capture == NULL) {
+    fprintf(stderr, "usage: %s [--quiet] [--golden expected.txt] capture.nmea\n", argv[0]);
+    return 2;
+  }
+  SerialUSB.feed(readFile(capture) + '\x04');
+  SerialUSB.capture = golden != NULL;
+  // Output buffers are set up beforehand, so that printing from inside
+  // the parsers doesn't count as their allocations.
+  static char stdoutBuffer[1 << 16];
+  setvbuf(stdout, stdoutBuffer, _IOFBF, sizeof(stdoutBuffer));
+  SerialUSB.out.reserve(1 << 22);
+  gpsReplayBegin(quiet);
+  gpsReplayPoll();
+  if (golden == NULL) return 0;
+  // The REPLAY line carries timings: keep everything else.
+  std::string out;
+  size_t start = 0, eol;
+  while ((eol = SerialUSB.out.find('\n', start)) != std::string::npos) {
+    if (SerialUSB.out.compare(start, 7, "REPLAY,") != 0) out += SerialUSB.out.substr(start, eol + 1 - start);
+    start = eol + 1;
+  }
+  std::string expected = readFile(golden);
+  if (out != expected) {
+    size_t i = 0;
+    while (i < out.size() && i < expected.size() && out[i] == expected[i]) i++;
+    size_t line = std::count(out.begin(), out.begin() + i, '\n') + 1;
+    printf("FAIL: %s differs from %s from line %zu\n", capture, golden, line);
+    return 1;
+  }
+  if (replayAllocs != 0) {
+    printf("FAIL: the parsers made %lu allocations\n", (unsigned long)replayAllocs);
+    return 1;
+  }
+  printf("replay: %lu sentences match %s, %lu cycles/sentence, 0 allocations\n",
+         (unsigned long)replaySentences, golden, (unsigned long)(replayCycles / replaySentences));
+  return 0;
+}
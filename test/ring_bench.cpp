@@ -0,0 +1,78 @@
+// Receive ring cost per byte, storing the sample capture in 128-byte
+// bursts as the interrupt would and draining each burst the way a reader
+// can: the old modulo ring byte by byte, the masked ring byte by byte,
+// with readBytes() into a 64-byte chunk, and with readUntil() a line at
+// a time.
+#include <Arduino.h>
+#include "SoftwareSerial1.h"
+#include "Hex_Helper.h"
+#include "GPS_Helper.h"
+#include "legacy.h"
+#include "bench.h"
+#include "probe.h"
+
+const size_t BURST = 128;
+const int ROUNDS = 200;
+
+// Times the stores and the drains separately: the masked ring's store
+// also keeps the receive counters, the old one's didn't.
+template <typename Store, typename Drain> void run(const char *name, const std::string &bytes, Store store, Drain drain) {
+  typedef std::chrono::steady_clock clock;
+  clock::duration storing{}, draining{};
+  volatile uint32_t sink = 0;
+  uint32_t allocs = heapAllocs;
+  for (int r = 0; r < ROUNDS; r++)
+    for (size_t i = 0; i < bytes.size(); i += BURST) {
+      size_t n = std::min(BURST, bytes.size() - i);
+      clock::time_point t0 = clock::now();
+      for (size_t j = 0; j < n; j++) store((uint8_t)bytes[i + j]);
+      clock::time_point t1 = clock::now();
+      sink += drain();
+      storing += t1 - t0;
+      draining += clock::now() - t1;
+    }
+  double n = (double)ROUNDS * bytes.size();
+  printf("  %-24s store %5.2f ns  drain %5.2f ns  %.2f allocations\n", name,
+         std::chrono::duration<double, std::nano>(storing).count() / n,
+         std::chrono::duration<double, std::nano>(draining).count() / n, (heapAllocs - allocs) / n);
+}
+
+int main(int argc, char **argv) {
+  std::string bytes = readFile(argc > 1 ? argv[1] : "data/sample.nmea");
+  static legacy::modRing old;
+  SoftwareSerial &port = gps;
+  printf("receive ring, %zu bytes x %d, per byte\n", bytes.size(), ROUNDS);
+
+  run("modulo, read()", bytes, [&](uint8_t d) {
+    old.store(d);
+  }, [&]() {
+    uint32_t sum = 0;
+    int c;
+    while ((c = old.read()) >= 0) sum += c;
+    return sum;
+  });
+  auto store = [&](uint8_t d) {
+    SoftwareSerialProbe::store(port, d);
+  };
+  run("masked, read()", bytes, store, [&]() {
+    uint32_t sum = 0;
+    int c;
+    while ((c = port.read()) >= 0) sum += c;
+    return sum;
+  });
+  run("masked, readBytes()", bytes, store, [&]() {
+    uint8_t chunk[64];
+    uint32_t sum = 0;
+    size_t n;
+    while ((n = port.readBytes(chunk, sizeof(chunk))) > 0) sum += chunk[n - 1];
+    return sum;
+  });
+  run("masked, readUntil()", bytes, store, [&]() {
+    uint8_t line[NMEA_MAX_LEN + 2];
+    uint32_t sum = 0;
+    size_t n;
+    while ((n = port.readUntil(line, sizeof(line), '\n')) > 0) sum += line[n - 1];
+    return sum;
+  });
+  return 0;
+}
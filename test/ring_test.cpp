@@ -0,0 +1,88 @@
+// Fuzzes SoftwareSerial's receive ring against a std::deque: random
+// bursts of stores (overflowing at times), read(), peek(), readBytes()
+// and readUntil(), long enough for the free-running 16-bit indices to
+// wrap many times. Runs an own-buffer port and the shared-buffer one.
+#include <Arduino.h>
+#include "SoftwareSerial1.h"
+#include "probe.h"
+#include <algorithm>
+#include <deque>
+#include <random>
+
+bool fuzz(SoftwareSerial &port, size_t capacity, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::deque<uint8_t> ref;
+  uint32_t dropped = 0;
+  uint8_t buffer[2048];
+  for (long op = 0; op < 2000000; op++) {
+    switch (rng() % 5) {
+      case 0:
+      case 1: {
+        // A burst, sometimes bigger than the free space.
+        size_t n = rng() % (capacity / 4);
+        for (size_t i = 0; i < n; i++) {
+          uint8_t d = rng();
+          SoftwareSerialProbe::store(port, d);
+          if (ref.size() < capacity) ref.push_back(d);
+          else dropped++;
+        }
+        break;
+      }
+      case 2: {
+        size_t n = rng() % (capacity + 64), got = port.readBytes(buffer, n);
+        if (got != std::min(n, ref.size())) {
+          printf("FAIL: readBytes(%zu) gave %zu of %zu\n", n, got, ref.size());
+          return false;
+        }
+        for (size_t i = 0; i < got; i++, ref.pop_front())
+          if (buffer[i] != ref.front()) {
+            printf("FAIL: readBytes byte %zu\n", i);
+            return false;
+          }
+        break;
+      }
+      case 3: {
+        size_t n = rng() % (capacity + 64), expected = 0;
+        char terminator = rng() % 16;
+        while (expected < n && expected < ref.size())
+          if ((char)ref[expected++] == terminator) break;
+        size_t got = port.readUntil(buffer, n, terminator);
+        if (got != expected) {
+          printf("FAIL: readUntil(%zu) gave %zu, expected %zu\n", n, got, expected);
+          return false;
+        }
+        for (size_t i = 0; i < got; i++, ref.pop_front())
+          if (buffer[i] != ref.front()) {
+            printf("FAIL: readUntil byte %zu\n", i);
+            return false;
+          }
+        break;
+      }
+      default: {
+        int expected = ref.empty() ? -1 : ref.front();
+        if (port.peek() != expected || port.read() != expected) {
+          printf("FAIL: peek()/read() didn't give %d\n", expected);
+          return false;
+        }
+        if (!ref.empty()) ref.pop_front();
+      }
+    }
+    if ((size_t)port.available() != ref.size()) {
+      printf("FAIL: available() %d, expected %zu\n", port.available(), ref.size());
+      return false;
+    }
+  }
+  if (SoftwareSerialProbe::stats(port).dropped != dropped) {
+    printf("FAIL: %lu dropped, expected %lu\n", (unsigned long)SoftwareSerialProbe::stats(port).dropped, (unsigned long)dropped);
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  SoftwareSerialT<256> own(3, 2);
+  SoftwareSerial shared(5, 4);
+  if (!fuzz(own, 256, 12) || !fuzz(shared, _SS_MAX_RX_BUFF, 34)) return 1;
+  printf("ring: 2 x 2M operations match std::deque\n");
+  return 0;
+}
@@ -0,0 +1,212 @@
+// Both receive engines against simulated waveforms, on a virtual clock.
+// The RX pin follows a synthetic sender with a rate error and edge
+// jitter. The pin and TC3 interrupts run recv() and recvTimerBit() after
+// a configurable latency, and delayMicroseconds() costs its argument
+// plus some overhead. Prints byte errors per 2000 bytes, by rate and
+// sender error, then by extra interrupt latency.
+//   waveform_bench [--pin-latency us] [--pin-jitter us] [--tc-latency us]
+//                  [--tc-jitter us] [--edge-jitter ns] [--delay-overhead us]
+#include <Arduino.h>
+#include "SoftwareSerial1.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+void TC3_Handler();
+
+const double US = F_CPU / 1000000; // cycles
+const double CYCLES_PER_TICK = (double)F_CPU / SS_RX_TC_HZ;
+const double NEVER = 1e300;
+const int BYTES = 2000;
+
+struct conditions {
+  double ppm; // sender's rate error
+  double edgeJitter; // each edge moves up to this much either way
+  double pinLatency, pinJitter; // pin interrupt entry: fixed, plus up to jitter
+  double tcLatency, tcJitter; // same for TC3
+  double delayOverhead; // added to every delayMicroseconds()
+  double gap; // idle time between bytes, up to this many bits
+};
+conditions cond = {0, 0.05 * US, 1.0 * US, 0.5 * US, 0.5 * US, 0.25 * US, 0.3 * US, 0};
+
+double now; // virtual time, CPU cycles
+std::mt19937 rng(16);
+std::vector<double> edgeTimes; // the line's transitions, in time order
+std::vector<bool> edgeLevels; // level after each
+void (*pinHandler)() = NULL;
+bool eicEnabled;
+double eicFlagSince; // edges after this set the EIC flag
+bool tcRunning;
+uint32_t tcTop;
+double tcWrap;
+
+double uniform(double max) {
+  return std::uniform_real_distribution<double>(0, max)(rng);
+}
+
+uint32_t hostPinRead() {
+  size_t i = std::upper_bound(edgeTimes.begin(), edgeTimes.end(), now) - edgeTimes.begin();
+  return i == 0 || edgeLevels[i - 1] ? 0xFFFFFFFF : 0;
+}
+
+uint32_t hostCycles() {
+  return (uint64_t)now;
+}
+
+uint64_t hostMicros() {
+  return now / US;
+}
+
+void delay(unsigned long ms) {
+  now += ms * 1000 * US;
+}
+
+void delayMicroseconds(unsigned int us) {
+  now += us * US + cond.delayOverhead;
+}
+
+void attachInterrupt(int, void (*handler)(), int) {
+  pinHandler = handler;
+  eicEnabled = true;
+}
+
+void hostRegWrite(const volatile void *reg, uint32_t value) {
+  TcCount16 *tc = &TC3->COUNT16;
+  if (reg == &EIC->INTENCLR.reg) eicEnabled = false;
+  else if (reg == &EIC->INTENSET.reg) eicEnabled = true;
+  else if (reg == &EIC->INTFLAG.reg) eicFlagSince = now;
+  else if (reg == &tc->CC[0].reg) tcTop = value;
+  else if (reg == &tc->CTRLBSET.reg && value == TC_CTRLBSET_CMD_RETRIGGER) {
+    tcRunning = true;
+    tcWrap = now + (tcTop + 1) * CYCLES_PER_TICK;
+  } else if (reg == &tc->CTRLBSET.reg && value == TC_CTRLBSET_CMD_STOP) tcRunning = false;
+}
+
+// First falling edge after t, the start of a start bit.
+double fallingEdgeAfter(double t) {
+  size_t i = std::upper_bound(edgeTimes.begin(), edgeTimes.end(), t) - edgeTimes.begin();
+  for (; i < edgeTimes.size(); i++)
+    if (!edgeLevels[i]) return edgeTimes[i];
+  return NEVER;
+}
+
+// 8N1 frames for bytes, from t on.
+void sendBytes(const std::vector<uint8_t> &bytes, double t, double baud) {
+  double bit = F_CPU / (baud * (1 + cond.ppm / 1e6));
+  bool level = true;
+  edgeTimes.clear();
+  edgeLevels.clear();
+  for (uint8_t b : bytes) {
+    uint16_t frame = (b | 0x100) << 1; // start bit, data LSB first, stop bit
+    for (uint8_t i = 0; i < 10; i++, t += bit) {
+      bool high = frame >> i & 1;
+      if (high == level) continue;
+      level = high;
+      edgeTimes.push_back(std::max(t + uniform(2 * cond.edgeJitter) - cond.edgeJitter, edgeTimes.empty() ? 0 : edgeTimes.back()));
+      edgeLevels.push_back(level);
+    }
+    t += bit * uniform(cond.gap);
+  }
+}
+
+// Runs interrupts until the line has gone quiet and the receiver is idle.
+void runInterrupts() {
+  double pinLate = cond.pinLatency + uniform(cond.pinJitter), tcLate = cond.tcLatency + uniform(cond.tcJitter);
+  for (;;) {
+    double pin = NEVER, tc = NEVER;
+    if (eicEnabled && pinHandler) {
+      double edge = fallingEdgeAfter(eicFlagSince);
+      if (edge < NEVER) pin = std::max(edge + pinLate, now);
+    }
+    if (tcRunning) tc = std::max(tcWrap + tcLate, now);
+    if (pin == NEVER && tc == NEVER) return;
+    if (tc <= pin) {
+      // TC3 outranks the pin interrupt, and reloads from CC0 at the wrap.
+      now = tc;
+      while (tcWrap <= now) tcWrap += (tcTop + 1) * CYCLES_PER_TICK;
+      tcLate = cond.tcLatency + uniform(cond.tcJitter);
+      TC3_Handler();
+    } else {
+      now = pin;
+      eicFlagSince = now;
+      pinLate = cond.pinLatency + uniform(cond.pinJitter);
+      pinHandler();
+    }
+  }
+}
+
+struct result {
+  uint32_t errors, framing;
+};
+
+result receive(uint8_t engine, long baud) {
+  SoftwareSerialT<4096> receiver(1, 0);
+  std::vector<uint8_t> sent(BYTES);
+  for (uint8_t &b : sent) b = rng();
+  now = 0;
+  eicEnabled = tcRunning = false;
+  eicFlagSince = 0;
+  edgeTimes.clear();
+  edgeLevels.clear();
+  receiver.setRxEngine(engine);
+  receiver.begin(baud);
+  sendBytes(sent, now + 20 * US, baud);
+  runInterrupts();
+  std::vector<uint8_t> got(2 * BYTES);
+  size_t count = receiver.readBytes(got.data(), got.size());
+  result r = {0, 0};
+  for (size_t i = 0; i < count && i < sent.size(); i++)
+    if (got[i] != sent[i]) r.errors++;
+  r.errors += count > sent.size() ? count - sent.size() : sent.size() - count;
+  SoftwareSerialStats st;
+  receiver.rxStats(st);
+  r.framing = st.framingErrors;
+  return r;
+}
+
+const long rates[] = {9600, 19200, 38400, 57600, 115200};
+const uint8_t engines[] = {SS_RX_BUSYWAIT, SS_RX_TIMER};
+const char *engineNames[] = {"busywait", "timer"};
+
+void table(const char *title, const char *unit, const double *values, uint8_t count, double conditions::*field, double scale) {
+  conditions base = cond;
+  printf("\n%s\nengine    baud", title);
+  for (uint8_t v = 0; v < count; v++) printf(" %7g%s", values[v], unit);
+  printf("\n");
+  for (uint8_t e = 0; e < 2; e++)
+    for (long baud : rates) {
+      printf("%-8s %6ld", engineNames[e], baud);
+      for (uint8_t v = 0; v < count; v++) {
+        cond.*field = base.*field + values[v] * scale;
+        result r = receive(engines[e], baud);
+        printf(" %*lu", 7 + (int)strlen(unit), (unsigned long)r.errors);
+      }
+      printf("\n");
+      cond = base;
+    }
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    double v = atof(argv[i + 1]);
+    if (strcmp(argv[i], "--pin-latency") == 0) cond.pinLatency = v * US;
+    else if (strcmp(argv[i], "--pin-jitter") == 0) cond.pinJitter = v * US;
+    else if (strcmp(argv[i], "--tc-latency") == 0) cond.tcLatency = v * US;
+    else if (strcmp(argv[i], "--tc-jitter") == 0) cond.tcJitter = v * US;
+    else if (strcmp(argv[i], "--edge-jitter") == 0) cond.edgeJitter = v * US / 1000;
+    else if (strcmp(argv[i], "--delay-overhead") == 0) cond.delayOverhead = v * US;
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 2;
+    }
+  }
+  printf("waveform: %d bytes back to back per cell, byte errors\n", BYTES);
+  printf("pin interrupt %.2f+%.2f us, TC3 %.2f+%.2f us, edges +-%.0f ns, delayMicroseconds() +%.2f us\n",
+         cond.pinLatency / US, cond.pinJitter / US, cond.tcLatency / US, cond.tcJitter / US,
+         cond.edgeJitter / US * 1000, cond.delayOverhead / US);
+  const double ppm[] = {-40000, -30000, -20000, -10000, 0, 10000, 20000, 30000, 40000};
+  table("Sender rate error", "ppm", ppm, 9, &conditions::ppm, 1);
+  const double late[] = {0, 1, 2, 4, 8, 16};
+  table("Extra pin interrupt jitter, on top of the above", "us", late, 6, &conditions::pinJitter, US);
+  return 0;
+}